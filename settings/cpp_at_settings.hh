@@ -2,9 +2,107 @@
 #define CPP_AT_SETTINGS_HH_
 
 // Override these values to suit your needs!
+#ifndef CPP_AT_COMMAND_MAX_LEN
 #define CPP_AT_COMMAND_MAX_LEN 32
+#endif
+#ifndef CPP_AT_ARG_MAX_LEN
 #define CPP_AT_ARG_MAX_LEN 128
+#endif
+#ifndef CPP_AT_HELP_STR_MAX_LEN
 #define CPP_AT_HELP_STR_MAX_LEN 200
+#endif
+#ifndef CPP_AT_MAX_NUM_ARGS
 #define CPP_AT_MAX_NUM_ARGS 20
+#endif
 
-#endif
\ No newline at end of file
+// Heap-free build profile. When set to 1, CppAT never calls operator new or malloc: copied command lists are stored
+// in a table inside the CppAT object, and callbacks are stored in fixed size buffers instead of std::function.
+#ifndef CPP_AT_HEAP_FREE
+#define CPP_AT_HEAP_FREE 0
+#endif
+// Maximum number of commands that can be copied into a CppAT object when CPP_AT_HEAP_FREE is set.
+#ifndef CPP_AT_MAX_NUM_COMMANDS
+#define CPP_AT_MAX_NUM_COMMANDS 32
+#endif
+// Maximum size in bytes of a callable (function pointer, lambda captures, std::bind result) stored as a callback
+// when CPP_AT_HEAP_FREE is set.
+#ifndef CPP_AT_CALLBACK_MAX_SIZE
+#define CPP_AT_CALLBACK_MAX_SIZE 32
+#endif
+
+// Storage class for the per-thread active CppATOutputBuffer. Define as empty on targets without thread local storage.
+#ifndef CPP_AT_THREAD_LOCAL
+#define CPP_AT_THREAD_LOCAL thread_local
+#endif
+
+// Size of the stack buffer used by CppAT::Format when no CppATOutputBuffer is active. Longer responses are passed to
+// cpp_at_printf in several pieces.
+#ifndef CPP_AT_FORMAT_BUFFER_LEN
+#define CPP_AT_FORMAT_BUFFER_LEN 64
+#endif
+
+// Size of the receive and transmit buffers of each CppATEpollServer session.
+#ifndef CPP_AT_SERVER_RX_BUFFER_LEN
+#define CPP_AT_SERVER_RX_BUFFER_LEN 512
+#endif
+#ifndef CPP_AT_SERVER_TX_BUFFER_LEN
+#define CPP_AT_SERVER_TX_BUFFER_LEN 2048
+#endif
+
+// Size of the buffer that captures the output of each command run by CppATDispatcher.
+#ifndef CPP_AT_DISPATCHER_OUTPUT_LEN
+#define CPP_AT_DISPATCHER_OUTPUT_LEN 1024
+#endif
+
+// Set to 0 to decode hex and base64 arguments with lookup tables only, even on CPUs with SSE2/SSSE3/AVX2.
+#ifndef CPP_AT_CODEC_SIMD
+#define CPP_AT_CODEC_SIMD 1
+#endif
+
+// Size of the buffer that collects a response to a framed line when no CppATOutputBuffer is active. Longer responses
+// are truncated, and their trailer covers the truncated text.
+#ifndef CPP_AT_FRAME_RESPONSE_LEN
+#define CPP_AT_FRAME_RESPONSE_LEN 256
+#endif
+// Set to 0 to compute CRC32C for framed lines with the lookup table only, even on CPUs with a crc32 instruction.
+#ifndef CPP_AT_FRAME_HW_CRC
+#define CPP_AT_FRAME_HW_CRC 1
+#endif
+
+// Default capacity in bytes of a CppATProfileStore, and the maximum number of settings it can hold.
+#ifndef CPP_AT_PROFILE_CAPACITY
+#define CPP_AT_PROFILE_CAPACITY 4096
+#endif
+#ifndef CPP_AT_PROFILE_MAX_NUM_SETTINGS
+#define CPP_AT_PROFILE_MAX_NUM_SETTINGS 64
+#endif
+
+// Maximum number of calls, and of arguments across those calls, passed to a batch_callback at once. Longer runs of the
+// same command are split into several batches. Messages that call a command with a batch_callback hold a batch on the
+// stack: about 40 bytes per call plus 16 per argument on 64 bit targets, roughly 3.3 KB with these defaults.
+#ifndef CPP_AT_BATCH_MAX_LEN
+#define CPP_AT_BATCH_MAX_LEN 32
+#endif
+#ifndef CPP_AT_BATCH_MAX_NUM_ARGS
+#define CPP_AT_BATCH_MAX_NUM_ARGS 128
+#endif
+
+// Capacity of a CppATScriptStore: number of scripts and length of their names, and the number of steps, arguments and
+// bytes of argument text across all scripts.
+#ifndef CPP_AT_SCRIPT_MAX_NUM_SCRIPTS
+#define CPP_AT_SCRIPT_MAX_NUM_SCRIPTS 8
+#endif
+#ifndef CPP_AT_SCRIPT_NAME_MAX_LEN
+#define CPP_AT_SCRIPT_NAME_MAX_LEN 16
+#endif
+#ifndef CPP_AT_SCRIPT_MAX_NUM_STEPS
+#define CPP_AT_SCRIPT_MAX_NUM_STEPS 128
+#endif
+#ifndef CPP_AT_SCRIPT_MAX_NUM_ARGS
+#define CPP_AT_SCRIPT_MAX_NUM_ARGS 256
+#endif
+#ifndef CPP_AT_SCRIPT_TEXT_LEN
+#define CPP_AT_SCRIPT_TEXT_LEN 4096
+#endif
+
+#endif
@@ -1,44 +1,214 @@
 #ifndef _CPP_AT_HH_
 #define _CPP_AT_HH_
 
+#include <algorithm> // for std::count
+#include <array>
+#include <atomic>
+#include <charconv> // for std::from_chars
+#include <chrono>
 #include <cctype> // for std::isspace()
+#include <cerrno> // for errno, ERANGE
+#include <cstring> // for strncpy
 #include <functional>
+#include <iterator> // for std::default_sentinel_t
+#include <limits>
+#include <memory> // for std::destroy_n, std::uninitialized_value_construct_n
+#include <memory_resource>
+#include <span>
 #include <string_view>
 #include <vector>
 #include <type_traits> // For checking tyupe of a template.
+#include "cpp_at_codec.hh"
+#include "cpp_at_format.hh"
+#include "cpp_at_function.hh"
+#include "cpp_at_output.hh"
+#include "cpp_at_profile_interface.hh"
+#include "cpp_at_script.hh"
 #include "cpp_at_settings.hh"
+#include "cpp_at_trace.hh"
 #include "stdint.h"
 #include "stdlib.h" // For strtol, strtoul, strtof.
 
-class CppAT
+/**
+ * @brief Lazy, forward-only view of the comma separated arguments of a command. Arguments are split from the raw
+ * message text only when they are asked for, so there is no limit on their number or length and arguments that are
+ * never read cost nothing. The views point into the received message and are not null terminated.
+ */
+class CppATArgs
 {
 public:
-    static constexpr uint16_t kATCommandMaxLen = CPP_AT_COMMAND_MAX_LEN;
-    // Initialized in .cc file.
-    static const char kATPrefix[];
-    static const uint16_t kATPrefixLen;
-    static const char kATAllowedOpChars[];
-    static constexpr uint16_t kHelpStringMaxLen = CPP_AT_HELP_STR_MAX_LEN;
-    static constexpr uint16_t kArgMaxLen = CPP_AT_ARG_MAX_LEN;
     static constexpr char kArgDelimiter = ',';
-    static constexpr uint16_t kMaxNumArgs = CPP_AT_MAX_NUM_ARGS;
-    static const char kATMessageEndStr[];
-
-    struct ATCommandDef_t
-    {
-        char command_buf[kATCommandMaxLen + 1] = ""; // leave room for '\0'
-        std::string_view command = {command_buf};    // Letters that come after the "AT+" prefix.
-        uint16_t min_args = 0;                       // Minimum number of arguments to expect after AT+<command>.
-        uint16_t max_args = 100;                     // Maximum number of arguments to expect after AT+<command>.
-        char help_string_buf[kHelpStringMaxLen + 1] =
-            "Help string not defined."; // Text to print when listing available AT commands.
-        std::string_view help_string = {help_string_buf};
-        std::function<void(void)> help_callback = nullptr; // Optional function to use for printing help string instead of help_string.
-        std::function<bool(const ATCommandDef_t &, char, const std::string_view[], uint16_t)> callback =
-            nullptr; // Function to call with list of arguments when an AT command is received.
+
+    explicit CppATArgs(std::string_view args_string)
+        : args_string_(args_string), rest_(args_string), has_next_(!args_string.empty())
+    {
+    }
+
+    /**
+     * @brief Pulls the next argument. A trailing delimiter counts as a final blank argument, like in ParseMessage.
+     * @param[out] arg The next argument.
+     * @retval True if there was another argument, false if all arguments have been read.
+     */
+    bool Next(std::string_view &arg) { return Split(rest_, has_next_, arg); }
+
+    /**
+     * @brief Returns true if Next() will return another argument.
+     */
+    bool HasNext() const { return has_next_; }
+
+    /**
+     * @brief Returns the text of the arguments that haven't been pulled yet, e.g. to pass to CppAT::ArgsToNums.
+     */
+    std::string_view GetRemaining() const { return rest_; }
+
+    /**
+     * @brief Returns the full argument text.
+     */
+    std::string_view GetString() const { return args_string_; }
+
+    /**
+     * Iterator for range-based for loops. Always starts from the first argument, independent of Next().
+     */
+    class Iterator
+    {
+    public:
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+        explicit Iterator(std::string_view args_string) : rest_(args_string), has_next_(!args_string.empty())
+        {
+            ++(*this);
+        }
+
+        std::string_view operator*() const { return arg_; }
+        Iterator &operator++()
+        {
+            is_end_ = !Split(rest_, has_next_, arg_);
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+        bool operator==(std::default_sentinel_t) const { return is_end_; }
+
+    private:
+        std::string_view rest_;
+        bool has_next_ = false;
+        std::string_view arg_;
+        bool is_end_ = true;
     };
 
-    CppAT(); // default constructor
+    Iterator begin() const { return Iterator(args_string_); }
+    std::default_sentinel_t end() const { return std::default_sentinel; }
+
+private:
+    static bool Split(std::string_view &rest, bool &has_next, std::string_view &arg)
+    {
+        if (!has_next)
+        {
+            return false;
+        }
+        size_t delimiter = rest.find(kArgDelimiter);
+        if (delimiter == std::string_view::npos)
+        {
+            arg = rest;
+            rest = {};
+            has_next = false;
+        }
+        else
+        {
+            arg = rest.substr(0, delimiter);
+            rest = rest.substr(delimiter + 1);
+        }
+        return true;
+    }
+
+    std::string_view args_string_;
+    std::string_view rest_;
+    bool has_next_;
+};
+
+/**
+ * @brief One call of a command passed to a batch_callback. The argument views point into the received message and are
+ * not null terminated.
+ */
+struct CppATInvocation_t
+{
+    char op = '\0';                        // Operator character, e.g. '=' or '?'.
+    std::span<const std::string_view> args; // Split arguments.
+    std::string_view args_string;           // Unsplit argument text, e.g. to pass to CppAT::ArgsToNums.
+};
+
+/**
+ * @brief Definition of a single AT command. Buffer sizes are template parameters so that each parser configuration
+ * only pays for the command and help string lengths that it needs.
+ */
+template <uint16_t kATCommandMaxLen, uint16_t kHelpStringMaxLen>
+struct BasicATCommandDef
+{
+    char command_buf[kATCommandMaxLen + 1] = ""; // leave room for '\0'
+    std::string_view command = {command_buf};    // Letters that come after the "AT+" prefix.
+    uint16_t min_args = 0;                       // Minimum number of arguments to expect after AT+<command>.
+    uint16_t max_args = 100;                     // Maximum number of arguments to expect after AT+<command>.
+    char help_string_buf[kHelpStringMaxLen + 1] =
+        "Help string not defined."; // Text to print when listing available AT commands.
+    std::string_view help_string = {help_string_buf};
+    CppATFunction<void(void)> help_callback =
+        nullptr; // Optional function to use for printing help string instead of help_string.
+    CppATFunction<bool(const BasicATCommandDef &, char, const std::string_view[], uint16_t)> callback =
+        nullptr; // Function to call with list of arguments when an AT command is received.
+    CppATFunction<bool(const BasicATCommandDef &, char, CppATArgs)> raw_callback =
+        nullptr; // Optional function that pulls its own arguments, used instead of callback. Ignores min/max_args.
+                 // Can't be combined with batch_callback.
+    CppATFunction<void(const BasicATCommandDef &, std::span<const CppATInvocation_t>, std::span<bool>)> batch_callback =
+        nullptr; // Optional function called once for consecutive calls of the command, used instead of callback.
+    uint16_t executor = UINT16_MAX; // CppATDispatcher worker that must run the command, or UINT16_MAX for any worker.
+    uint32_t latency_budget_us = 0; // Longest the callback is expected to take, or 0 for no budget.
+};
+
+/**
+ * @brief AT command parser with per-instance limits.
+ * @tparam CommandMaxLen Maximum length of a command string (e.g. "+CONFIG").
+ * @tparam MaxNumArgs Maximum number of arguments accepted by ParseMessage.
+ * @tparam ArgMaxLen Maximum length of a single argument.
+ * @tparam HelpStringMaxLen Maximum length of a help string.
+ * @tparam MaxNumCommands Number of command definitions that can be copied into the parser object. If 0, copied
+ * command lists are stored in dynamic memory instead.
+ */
+template <uint16_t CommandMaxLen = CPP_AT_COMMAND_MAX_LEN, uint16_t MaxNumArgs = CPP_AT_MAX_NUM_ARGS,
+          uint16_t ArgMaxLen = CPP_AT_ARG_MAX_LEN, uint16_t HelpStringMaxLen = CPP_AT_HELP_STR_MAX_LEN,
+          uint16_t MaxNumCommands = (CPP_AT_HEAP_FREE ? CPP_AT_MAX_NUM_COMMANDS : 0)>
+class BasicCppAT
+{
+public:
+    static constexpr uint16_t kATCommandMaxLen = CommandMaxLen;
+    static constexpr char kATPrefix[] = "AT";
+    static constexpr uint16_t kATPrefixLen = sizeof(kATPrefix) - 1; // Remove EOS character.
+    static constexpr char kATAllowedOpChars[] = "? =\r\n";           // NOTE: these delimit the end of a command!
+    static constexpr uint16_t kHelpStringMaxLen = HelpStringMaxLen;
+    static constexpr uint16_t kArgMaxLen = ArgMaxLen;
+    static constexpr char kArgDelimiter = ',';
+    static constexpr uint16_t kMaxNumArgs = MaxNumArgs;
+    static constexpr uint16_t kMaxNumCommands = MaxNumCommands;
+    static constexpr char kATMessageEndStr[] = "\r\n";
+    static constexpr uint16_t kBatchMaxLen = CPP_AT_BATCH_MAX_LEN;
+    static constexpr uint16_t kBatchMaxNumArgs = CPP_AT_BATCH_MAX_NUM_ARGS;
+    static constexpr char kScriptStepDelimiter = ';';
+    static constexpr char kScriptIgnoreFailurePrefix = '~';
+
+    using ATCommandDef_t = BasicATCommandDef<kATCommandMaxLen, kHelpStringMaxLen>;
+
+    BasicCppAT(); // default constructor
+
+    /**
+     * @brief Constructor for a parser that gets its command list later through SetATCommandList.
+     * @param[in] memory_resource Memory resource that copied command lists are allocated from.
+     */
+    explicit BasicCppAT(std::pmr::memory_resource *memory_resource);
 
     /**
      * @brief Constructor.
@@ -46,17 +216,42 @@ public:
      * as well as their corresponding callback functions.
      * @param[in] num_at_comands_in Length of at_command_list_in.
      * @param[in] at_command_list_is_static Optional boolean indicating whether the at_command_list is statically
-     * allocated and can be used directly, or whether new space needs to be allocated for it in dynamic memory. NOTE: An
-     * AT+HELP function will not be automatically generated if this is set to true.
+     * allocated and can be used directly, or whether new space needs to be allocated for it in dynamic memory. When
+     * kMaxNumCommands is nonzero, the copy is stored inside the parser object instead.
+     * @param[in] memory_resource Optional memory resource (e.g. a std::pmr::monotonic_buffer_resource) that copied
+     * command lists are allocated from. Takes precedence over the table of kMaxNumCommands entries. If nullptr,
+     * std::pmr::get_default_resource() is used when there is no table.
      * @retval Your shiny new CppAT object.
      */
-    CppAT(const ATCommandDef_t *at_command_list_in, uint16_t num_at_commands_in,
-          bool at_command_list_is_static = false); // Constructor.
+    BasicCppAT(const ATCommandDef_t *at_command_list_in, uint16_t num_at_commands_in,
+               bool at_command_list_is_static = false,
+               std::pmr::memory_resource *memory_resource = nullptr); // Constructor.
 
     /**
      * @brief Destructor. Deallocates dynamically allocated memory.
      */
-    ~CppAT();
+    ~BasicCppAT();
+
+    /**
+     * @brief Move constructor. Takes over the command list without copying it (unless it is stored in the table of
+     * kMaxNumCommands entries inside the parser) along with the memory resource it came from, and leaves other
+     * without commands. The AT+HELP command is bound to the new parser.
+     */
+    BasicCppAT(BasicCppAT &&other) noexcept;
+
+    /**
+     * @brief Move assignment. Frees the current command list, then behaves like the move constructor.
+     */
+    BasicCppAT &operator=(BasicCppAT &&other) noexcept;
+
+    // Copying would have two parsers sharing one command list.
+    BasicCppAT(const BasicCppAT &) = delete;
+    BasicCppAT &operator=(const BasicCppAT &) = delete;
+
+    /**
+     * @brief Returns the memory resource passed to the constructor, or nullptr if there wasn't one.
+     */
+    std::pmr::memory_resource *GetMemoryResource() const { return memory_resource_; }
 
     /**
      * @brief Helper function that clears existing AT commands and populates with a new list of AT Command definitions.
@@ -65,15 +260,17 @@ public:
      * as well as their corresponding callback functions.
      * @param[in] num_at_commands Number of elements in at_command_list_in array.
      * @param[in] at_command_list_is_static Optional boolean indicating whether at_command_list can be referenced in
-     * place. If not, memory will be dynamically allocated to store the contents of at_command_list.
+     * place. If not, the contents of at_command_list are copied into a table of kMaxNumCommands entries inside the
+     * parser, or into dynamic memory if kMaxNumCommands is 0.
      * @retval True if set successfully, false if failed.
      */
     bool SetATCommandList(const ATCommandDef_t *at_command_list_in, uint16_t num_at_commands_in,
                           bool at_command_list_is_static = false);
 
     /**
-     * @brief Returns the number of supported AT commands, not counting the auto-generated AT+HELP command.
-     * @retval Size of at_command_list_.
+     * @brief Returns the number of supported AT commands, including the auto-generated AT+HELP command, the AT&W, ATZ
+     * and AT&F commands added by SetProfileStore and the AT+SCRIPT and AT+RUN commands added by SetScriptStore.
+     * @retval Size of at_command_list_ plus the auto-generated commands.
      */
     uint16_t GetNumATCommands();
 
@@ -84,6 +281,101 @@ public:
      */
     const ATCommandDef_t *LookupATCommand(std::string_view command);
 
+    /**
+     * @brief Returns the ATCommandDef_t at a given index. The auto-generated AT+HELP command comes after the command
+     * list, followed by the profile commands if a profile store is attached and the script commands if a script store
+     * is attached.
+     * @param[in] index Index of the command.
+     * @retval Pointer to the ATCommandDef_t, or nullptr if index is out of range.
+     */
+    const ATCommandDef_t *GetATCommand(uint16_t index);
+
+    /**
+     * @brief Returns the index of an ATCommandDef_t returned by LookupATCommand or GetATCommand.
+     * @param[in] def Pointer to the command definition.
+     * @retval Index of the command, or CppATTraceBuffer::kCommandIndexNone if it isn't part of this parser.
+     */
+    uint16_t GetATCommandIndex(const ATCommandDef_t *def);
+
+    /**
+     * @brief Attaches a flight recorder that receives a binary record for every command handled by ParseMessage,
+     * including commands that fail to parse. The same trace buffer can be shared by multiple parsers and threads.
+     * @param[in] trace_buffer Trace buffer to record into, or nullptr to stop recording.
+     */
+    void SetTraceBuffer(CppATTraceBuffer *trace_buffer) { trace_buffer_ = trace_buffer; }
+
+    /**
+     * @brief Returns the attached flight recorder, or nullptr if there isn't one.
+     */
+    CppATTraceBuffer *GetTraceBuffer() const { return trace_buffer_; }
+
+    /**
+     * @brief Attaches a settings profile store and enables the AT&W (save settings), ATZ (restore saved settings) and
+     * AT&F (restore factory settings) commands. Commands in the command list with the same names take precedence.
+     * @param[in] profile_store Opened profile store (e.g. a CppATProfileStore), or nullptr to disable the profile
+     * commands.
+     */
+    void SetProfileStore(CppATProfileInterface *profile_store)
+    {
+        profile_store_ = profile_store;
+        ClearScripts(); // Command indices have changed.
+    }
+
+    /**
+     * @brief Attaches a script store and enables the AT+SCRIPT (store a script) and AT+RUN (run a script) commands.
+     * Commands in the command list with the same names take precedence. Scripts refer to commands by index, so the
+     * store is cleared whenever the commands of the parser change.
+     * @param[in] script_store Script store, or nullptr to disable the script commands.
+     */
+    void SetScriptStore(CppATScriptStore *script_store)
+    {
+        script_store_ = script_store;
+        ClearScripts();
+    }
+
+    /**
+     * @brief Compiles a script and stores it in the attached script store, replacing a script with the same name. Each
+     * command is looked up and its arguments are split and checked once, here, instead of every time the script runs.
+     * Not thread safe, don't call while a script is running.
+     * @param[in] name Name of the script.
+     * @param[in] steps Commands without the AT prefix separated by ';', e.g. "+CFG=1,2;+MODE?". Commands starting
+     * with '~' may fail without aborting the script.
+     * @retval True if the script was stored, false if a command is unknown, has the wrong number of arguments or
+     * doesn't fit in the store.
+     */
+    bool StoreScript(std::string_view name, std::string_view steps);
+
+    /**
+     * @brief Runs a script from the attached script store. Steps run in order and the first step that fails aborts the
+     * script, unless it was marked with '~'.
+     * @param[in] name Name of the script.
+     * @param[out] failed_step Optional destination for the index of the step that aborted the script.
+     * @retval True if every step succeeded or was allowed to fail, false otherwise.
+     */
+    bool RunScript(std::string_view name, uint16_t *failed_step = nullptr);
+
+    using Clock = uint64_t (*)(void);
+    using OverrunHook = CppATFunction<void(const ATCommandDef_t &def, uint64_t duration_us)>;
+
+    /**
+     * @brief Sets the function called when a callback takes longer than the latency_budget_us of its command. Called
+     * after the callback returns, on the thread that ran it.
+     * @param[in] overrun_hook Function receiving the command and how long its callback took, or nullptr.
+     */
+    void SetOverrunHook(OverrunHook overrun_hook) { overrun_hook_ = std::move(overrun_hook); }
+
+    /**
+     * @brief Sets the clock used to time callbacks against their latency budgets. Defaults to
+     * std::chrono::steady_clock.
+     * @param[in] clock Function returning a monotonic time in nanoseconds.
+     */
+    void SetClock(Clock clock) { clock_ = clock; }
+
+    /**
+     * @brief Returns the number of callbacks that took longer than their latency budget.
+     */
+    uint32_t GetNumOverruns() const { return num_overruns_.load(std::memory_order_relaxed); }
+
     /**
      * @brief Parses a message to find the AT command, match it with the relevant ATCommandDef_t, parse
      * out the arguments and execute the corresponding callback function.
@@ -92,6 +384,20 @@ public:
      */
     bool ParseMessage(std::string_view message);
 
+    /**
+     * @brief Runs the callback of a command whose arguments have already been split, whatever kind of callback it
+     * has, e.g. for transports that don't carry text AT lines (see CppATParseBinaryMessage). Tracing and latency
+     * budgets apply as in ParseMessage.
+     * @param[in] def Command to call, e.g. from GetATCommand().
+     * @param[in] op Operator character, or '\0' for none.
+     * @param[in] args Split arguments. Must be null terminated for commands with a plain callback.
+     * @param[in] num_args Number of arguments.
+     * @param[in] args_string Unsplit argument text, passed to raw and batch callbacks.
+     * @retval Result of the callback, or true if the command has no callback.
+     */
+    bool CallATCommand(const ATCommandDef_t *def, char op, const std::string_view args[], uint16_t num_args,
+                       std::string_view args_string);
+
     bool is_valid = false;
 
     /**
@@ -166,89 +472,1630 @@ public:
         return false;
     }
 
-    bool ATHelpCallback(const ATCommandDef_t &def, char op, const std::string_view args[], uint16_t num_args);
-    const ATCommandDef_t at_help_command = {
-        .command_buf = "+HELP",
-        .min_args = 0,
-        .max_args = 0,
-        .help_string_buf = "Display this menu.\r\n",
-        .callback = std::bind(&CppAT::ATHelpCallback, this, std::placeholders::_1, std::placeholders::_2,
-                              std::placeholders::_3, std::placeholders::_4)};
-
     /**
-     * @brief printf handle used by CppAT.
-     * @param[in] Format string used for printing.
-     * @param[in] ... Variable length list of arguments.
-     * @retval The number of characters printed, or EOF if an error occurred.
+     * Per-value result of ArgsToNums.
      */
-    static int cpp_at_printf(const char *format, ...);
-
-private:
-    // Non readonly handle for at_command_list_ used when it is dynamically allocated into memory.
-    ATCommandDef_t *at_command_list_ = nullptr;
-    // Readonly handle for at_command_list_ used everywhere except where it is set.
-    const ATCommandDef_t *at_command_list_ro_ = nullptr;
-    uint16_t num_at_commands_;
-};
+    enum class ArgError : uint8_t
+    {
+        kNone = 0,      // Value was parsed.
+        kBlank = 1,     // Value was empty or only whitespace.
+        kInvalid = 2,   // Value contained characters that aren't part of a number.
+        kOutOfRange = 3 // Value doesn't fit in the destination type.
+    };
 
-/** CppAT Convenience Macros */
-// NOTE: do {} while (false) structure is used on standalone multi-line macros to create a single block and force use of
-// a semicolon after calling the macro.
+    struct ArgsToNumsResult_t
+    {
+        size_t num_values = 0;               // Number of values found, may be larger than the destination.
+        size_t num_errors = 0;               // Number of values that failed to parse.
+        size_t first_error_index = SIZE_MAX; // Index of the first value that failed to parse.
+    };
 
-#define CPP_AT_HAS_ARG(n) (num_args > (n) && !args[(n)].empty())
+    /**
+     * @brief Decodes a comma separated list of numbers (e.g. the argument string "1,2,3") in a single pass, without
+     * copying or splitting it into arguments first. There is no limit on the number of values.
+     * @param[in] args_string Comma separated values. Whitespace around each value is ignored.
+     * @param[out] numbers Destination for the values. Values past its end are counted but not stored.
+     * @param[out] errors Optional destination for the result of each value, can be shorter than numbers.
+     * @param[in] base Base to use for integers (2-36). Base 16 values may start with "0x".
+     * @retval Number of values found and number of errors. Succeeded if num_errors is 0 and num_values fits in numbers.
+     * @note Floating point values are parsed with std::from_chars where the standard library supports it for floats
+     * (GCC 11 and newer), and with strtod otherwise. Integers don't use either.
+     */
+    template <typename T, size_t kExtent>
+    static ArgsToNumsResult_t ArgsToNums(std::string_view args_string, std::span<T, kExtent> numbers,
+                                         std::span<ArgError> errors = {}, uint16_t base = 10)
+    {
+        ArgsToNumsResult_t result;
+        if (args_string.empty())
+        {
+            return result;
+        }
+        const char *ptr = args_string.data();
+        const char *end = ptr + args_string.length();
+        while (true)
+        {
+            size_t index = result.num_values++;
+            T discarded;
+            ArgError error = ParseNum(ptr, end, index < numbers.size() ? numbers[index] : discarded, base);
+            RecordArgError(result, errors, index, error);
+            if (ptr == end)
+            {
+                break;
+            }
+            ptr++; // Skip the delimiter.
+        }
+        return result;
+    }
 
-#define CPP_AT_TRY_ARG2NUM(args_index, num)                                          \
-    do                                                                               \
-    {                                                                                \
-        if (!CppAT::ArgToNum(args[(args_index)], (num)))                             \
-        {                                                                            \
-            CppAT::cpp_at_printf("Error converting argument %d.\r\n", (args_index)); \
-            return false;                                                            \
-        }                                                                            \
-    } while (false)
+    /**
+     * @brief Decodes a run of arguments that were already split by ParseMessage.
+     * @param[in] args Arguments to decode, e.g. args + 1 to skip the first argument of a callback.
+     * @param[in] num_args Number of arguments to decode.
+     * @param[out] numbers Destination for the values. Values past its end are counted but not stored.
+     * @param[out] errors Optional destination for the result of each value, can be shorter than numbers.
+     * @param[in] base Base to use for integers (2-36). Base 16 values may start with "0x".
+     * @retval Number of values found and number of errors.
+     */
+    template <typename T, size_t kExtent>
+    static ArgsToNumsResult_t ArgsToNums(const std::string_view args[], uint16_t num_args,
+                                         std::span<T, kExtent> numbers, std::span<ArgError> errors = {},
+                                         uint16_t base = 10)
+    {
+        ArgsToNumsResult_t result;
+        for (uint16_t i = 0; i < num_args; i++)
+        {
+            size_t index = result.num_values++;
+            T discarded;
+            RecordArgError(result, errors, index,
+                           ParseArg(args[i], index < numbers.size() ? numbers[index] : discarded, base));
+        }
+        return result;
+    }
 
-#define CPP_AT_TRY_ARG2NUM_BASE(args_index, num, base)                                                    \
-    do                                                                                                    \
-    {                                                                                                     \
-        if (!CppAT::ArgToNum(args[(args_index)], (num), (base)))                                          \
-        {                                                                                                 \
-            CppAT::cpp_at_printf("Error converting argument %d with base %d.\r\n", (args_index), (base)); \
-            return false;                                                                                 \
-        }                                                                                                 \
-    } while (false)
+    /**
+     * @brief Version of ArgToNum for arguments that aren't null terminated, e.g. those pulled from CppATArgs. Integer
+     * types only accept integers.
+     * @param[in] arg string_view containing the value to parse.
+     * @param[out] number Reference to a uint, int, or float to write the value into.
+     * @param[in] base Base to use for integers (2-36).
+     * @retval ArgError::kNone if parsing was successful, the reason it failed otherwise.
+     */
+    template <typename T>
+    static ArgError ParseArg(std::string_view arg, T &number, uint16_t base = 10)
+    {
+        const char *ptr = arg.data();
+        const char *end = ptr + arg.length();
+        ArgError error = ParseNum(ptr, end, number, base);
+        if (error == ArgError::kNone && ptr != end)
+        {
+            error = ArgError::kInvalid; // Delimiter inside a single argument.
+        }
+        return error;
+    }
 
-#define CPP_AT_SUCCESS()                \
-    do                                  \
-    {                                   \
-        CppAT::cpp_at_printf("OK\r\n"); \
-        return true;                    \
-    } while (false)
+    /**
+     * @brief Decodes a hex argument (e.g. "DEADbeef") into bytes. There must be two digits per byte, without a "0x"
+     * prefix or separators.
+     * @param[in] arg string_view containing the hex digits.
+     * @param[out] bytes Destination for the decoded bytes.
+     * @param[out] num_bytes Number of bytes decoded.
+     * @retval ArgError::kNone if decoding was successful, kBlank if arg is empty, kInvalid if it isn't valid hex and
+     * kOutOfRange if it doesn't fit in bytes.
+     * @tparam Codec Decoder, only a template parameter so that programs that don't decode byte arguments don't need to
+     * link cpp_at_codec.cc.
+     */
+    template <typename Codec = CppATCodec>
+    static ArgError HexArgToBytes(std::string_view arg, std::span<uint8_t> bytes, size_t &num_bytes)
+    {
+        if (arg.empty())
+        {
+            return ArgError::kBlank;
+        }
+        if (arg.length() % 2 == 0 && arg.length() / 2 > bytes.size())
+        {
+            return ArgError::kOutOfRange;
+        }
+        return Codec::DecodeHex(arg, bytes, num_bytes) ? ArgError::kNone : ArgError::kInvalid;
+    }
 
-#define CPP_AT_SILENT_SUCCESS() return true
+    /**
+     * @brief Decodes a padded base64 argument (e.g. "3q2+7w==") into bytes.
+     * @param[in] arg string_view containing the base64 text.
+     * @param[out] bytes Destination for the decoded bytes.
+     * @param[out] num_bytes Number of bytes decoded.
+     * @retval ArgError::kNone if decoding was successful, kBlank if arg is empty, kInvalid if it isn't valid base64 and
+     * kOutOfRange if it doesn't fit in bytes.
+     * @tparam Codec Decoder, see HexArgToBytes().
+     */
+    template <typename Codec = CppATCodec>
+    static ArgError Base64ArgToBytes(std::string_view arg, std::span<uint8_t> bytes, size_t &num_bytes)
+    {
+        if (arg.empty())
+        {
+            return ArgError::kBlank;
+        }
+        if (Codec::GetBase64DecodedLen(arg) > bytes.size())
+        {
+            return ArgError::kOutOfRange;
+        }
+        return Codec::DecodeBase64(arg, bytes, num_bytes) ? ArgError::kNone : ArgError::kInvalid;
+    }
 
-#define CPP_AT_ERROR(format, ...)                                                \
-    do                                                                           \
-    {                                                                            \
-        CppAT::cpp_at_printf("ERROR " format "\r\n" __VA_OPT__(, ) __VA_ARGS__); \
-        return false;                                                            \
-    } while (false)
+    bool ATHelpCallback(const ATCommandDef_t &def, char op, const std::string_view args[], uint16_t num_args);
+    const ATCommandDef_t at_help_command = {
+        .command_buf = "+HELP",
+        .min_args = 0,
+        .max_args = 0,
+        .help_string_buf = "Display this menu.\r\n",
+        // Lambda capturing only this fits in the small buffer of CppATFunction (std::function or, in the heap-free
+        // profile, CppATInplaceFunction), so no allocation is needed.
+        .callback = [this](const ATCommandDef_t &def, char op, const std::string_view args[], uint16_t num_args)
+        { return ATHelpCallback(def, op, args, num_args); }};
 
-#define CPP_AT_CALLBACK(callback_name) \
-    bool callback_name(const CppAT::ATCommandDef_t &def, char op, const std::string_view args[], uint16_t num_args)
+    static constexpr uint16_t kNumProfileCommands = 3;
+    bool ATProfileCallback(const ATCommandDef_t &def, char op, const std::string_view args[], uint16_t num_args);
+    const ATCommandDef_t at_profile_commands[kNumProfileCommands] = {
+        {.command_buf = "&W",
+         .min_args = 0,
+         .max_args = 0,
+         .help_string_buf = "Save settings.\r\n",
+         .callback = [this](const ATCommandDef_t &def, char op, const std::string_view args[], uint16_t num_args)
+         { return ATProfileCallback(def, op, args, num_args); }},
+        {.command_buf = "Z",
+         .min_args = 0,
+         .max_args = 0,
+         .help_string_buf = "Restore saved settings.\r\n",
+         .callback = [this](const ATCommandDef_t &def, char op, const std::string_view args[], uint16_t num_args)
+         { return ATProfileCallback(def, op, args, num_args); }},
+        {.command_buf = "&F",
+         .min_args = 0,
+         .max_args = 0,
+         .help_string_buf = "Restore factory settings.\r\n",
+         .callback = [this](const ATCommandDef_t &def, char op, const std::string_view args[], uint16_t num_args)
+         { return ATProfileCallback(def, op, args, num_args); }}};
 
-#define CPP_AT_HELP_CALLBACK(callback_name) void callback_name()
+    static constexpr uint16_t kNumScriptCommands = 2;
+    bool ATScriptCallback(const ATCommandDef_t &def, char op, CppATArgs args);
+    bool ATRunCallback(const ATCommandDef_t &def, char op, const std::string_view args[], uint16_t num_args);
+    const ATCommandDef_t at_script_commands[kNumScriptCommands] = {
+        {.command_buf = "+SCRIPT",
+         .help_string_buf = "Store a script.\r\n",
+         .raw_callback = [this](const ATCommandDef_t &def, char op, CppATArgs args)
+         { return ATScriptCallback(def, op, args); }},
+        {.command_buf = "+RUN",
+         .min_args = 1,
+         .max_args = 1,
+         .help_string_buf = "Run a script.\r\n",
+         .callback = [this](const ATCommandDef_t &def, char op, const std::string_view args[], uint16_t num_args)
+         { return ATRunCallback(def, op, args, num_args); }}};
 
-#define CPP_AT_BIND_MEMBER_CALLBACK(callback, instance)                           \
-    std::bind(&callback, &instance, std::placeholders::_1, std::placeholders::_2, \
-              std::placeholders::_3, std::placeholders::_4)
+private:
+    /**
+     * @brief Parses a single number from ptr up to the next argument delimiter or end, and leaves ptr at the delimiter
+     * (or at end).
+     */
+    template <typename T>
+    static ArgError ParseNum(const char *&ptr, const char *end, T &number, uint16_t base)
+    {
+        auto skip_space = [&ptr, end]()
+        {
+            while (ptr < end && (*ptr == ' ' || *ptr == '\t'))
+            {
+                ++ptr;
+            }
+        };
+        auto skip_to_delimiter = [&ptr, end]()
+        {
+            while (ptr < end && *ptr != kArgDelimiter)
+            {
+                ++ptr;
+            }
+        };
 
-#define CPP_AT_BIND_MEMBER_HELP_CALLBACK(callback, instance) \
-    std::bind(&callback, &instance)
+        skip_space();
+        if (ptr == end || *ptr == kArgDelimiter)
+        {
+            return ArgError::kBlank;
+        }
+        ArgError error = ArgError::kNone;
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            if (*ptr == '+')
+            {
+                ++ptr;
+            }
+#if defined(__cpp_lib_to_chars)
+            std::from_chars_result parsed = std::from_chars(ptr, end, number);
+            if (parsed.ptr == ptr)
+            {
+                error = ArgError::kInvalid;
+            }
+            else if (parsed.ec == std::errc::result_out_of_range)
+            {
+                error = ArgError::kOutOfRange;
+            }
+            ptr = parsed.ptr;
+#else
+            // No floating point <charconv> (e.g. GCC 10), copy the value so strtod can read it null terminated.
+            char value_buf[64];
+            size_t value_len = 0;
+            while (ptr + value_len < end && ptr[value_len] != kArgDelimiter && value_len < sizeof(value_buf) - 1)
+            {
+                value_buf[value_len] = ptr[value_len];
+                value_len++;
+            }
+            value_buf[value_len] = '\0';
+            char *value_end;
+            errno = 0;
+            if constexpr (std::is_same_v<T, float>)
+            {
+                number = strtof(value_buf, &value_end);
+            }
+            else if constexpr (std::is_same_v<T, double>)
+            {
+                number = strtod(value_buf, &value_end);
+            }
+            else
+            {
+                number = static_cast<T>(strtold(value_buf, &value_end));
+            }
+            if (value_end == value_buf || std::isspace(static_cast<unsigned char>(value_buf[0])))
+            {
+                error = ArgError::kInvalid;
+            }
+            else if (errno == ERANGE)
+            {
+                error = ArgError::kOutOfRange;
+            }
+            ptr += value_end - value_buf;
+#endif
+        }
+        else
+        {
+            bool is_negative = *ptr == '-';
+            if (is_negative || *ptr == '+')
+            {
+                ++ptr;
+            }
+            if (base == 16 && end - ptr > 2 && ptr[0] == '0' && (ptr[1] == 'x' || ptr[1] == 'X'))
+            {
+                ptr += 2;
+            }
+            // Accumulate the magnitude in 64 bits, anything that exceeds it is out of range for every T.
+            uint64_t magnitude = 0;
+            bool overflowed = false;
+            const char *digits_start = ptr;
+            for (; ptr < end; ++ptr)
+            {
+                uint8_t c = static_cast<uint8_t>(*ptr);
+                uint8_t digit = c - '0';
+                if (digit > 9)
+                {
+                    digit = static_cast<uint8_t>((c | 0x20) - 'a') + 10; // Letters, case insensitive.
+                    if (digit < 10)
+                    {
+                        break; // Wrapped around, not a letter.
+                    }
+                }
+                if (digit >= base)
+                {
+                    break;
+                }
+#if defined(__GNUC__) || defined(__clang__)
+                overflowed |= __builtin_mul_overflow(magnitude, base, &magnitude);
+                overflowed |= __builtin_add_overflow(magnitude, digit, &magnitude);
+#else
+                overflowed |= magnitude > (UINT64_MAX - digit) / base;
+                magnitude = magnitude * base + digit;
+#endif
+            }
+            if (ptr == digits_start)
+            {
+                error = ArgError::kInvalid;
+            }
+            else if constexpr (std::is_signed_v<T>)
+            {
+                using Limits = std::numeric_limits<T>;
+                uint64_t max_magnitude = is_negative ? static_cast<uint64_t>(-(Limits::min() + 1)) + 1 : Limits::max();
+                if (overflowed || magnitude > max_magnitude)
+                {
+                    error = ArgError::kOutOfRange;
+                }
+                else
+                {
+                    number = is_negative ? static_cast<T>(0 - magnitude) : static_cast<T>(magnitude);
+                }
+            }
+            else
+            {
+                if (overflowed || magnitude > std::numeric_limits<T>::max() || (is_negative && magnitude != 0))
+                {
+                    error = ArgError::kOutOfRange;
+                }
+                else
+                {
+                    number = static_cast<T>(magnitude);
+                }
+            }
+        }
 
-#define CPP_AT_CMD_PRINTF(format, ...) \
-    CppAT::cpp_at_printf("%s" format "\r\n", def.command.data() __VA_OPT__(, ) __VA_ARGS__)
+        skip_space();
+        if (ptr < end && *ptr != kArgDelimiter)
+        {
+            error = ArgError::kInvalid; // Trailing text, e.g. "12abc".
+            skip_to_delimiter();
+        }
+        return error;
+    }
 
-#define CPP_AT_PRINTF(format, ...) \
-    CppAT::cpp_at_printf(format __VA_OPT__(, ) __VA_ARGS__)
+    static void RecordArgError(ArgsToNumsResult_t &result, std::span<ArgError> errors, size_t index, ArgError error)
+    {
+        if (index < errors.size())
+        {
+            errors[index] = error;
+        }
+        if (error != ArgError::kNone)
+        {
+            if (result.num_errors++ == 0)
+            {
+                result.first_error_index = index;
+            }
+        }
+    }
+
+    /**
+     * @brief Runs a command callback, recording its result and duration if tracing is on and checking it against the
+     * latency budget of the command.
+     */
+    template <typename Callback>
+    bool RunCallback(const ATCommandDef_t *def, char op, uint16_t num_args, std::string_view args_string,
+                     Callback call)
+    {
+        if (trace_buffer_ == nullptr && def->latency_budget_us == 0)
+        {
+            return call();
+        }
+        uint64_t timestamp_ns = trace_buffer_ != nullptr ? trace_buffer_->Now() : 0;
+        uint64_t start_ns = def->latency_budget_us > 0 ? clock_() : 0;
+        bool result = call();
+        if (def->latency_budget_us > 0)
+        {
+            uint64_t duration_us = (clock_() - start_ns) / 1000;
+            if (duration_us > def->latency_budget_us)
+            {
+                num_overruns_.fetch_add(1, std::memory_order_relaxed);
+                if (overrun_hook_)
+                {
+                    overrun_hook_(*def, duration_us);
+                }
+            }
+        }
+        if (trace_buffer_ != nullptr)
+        {
+            trace_buffer_->Record(GetATCommandIndex(def), op, num_args, args_string,
+                                  result ? CppATTraceBuffer::Result::kOK : CppATTraceBuffer::Result::kError,
+                                  timestamp_ns, trace_buffer_->Now() - timestamp_ns);
+        }
+        return result;
+    }
+
+    static uint64_t SteadyClockNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /**
+     * @brief Records a command that was rejected because of its arguments, if tracing is on.
+     */
+    void TraceBadArgs(const ATCommandDef_t *def, char op, uint16_t num_args, std::string_view args_string)
+    {
+        if (trace_buffer_ != nullptr)
+        {
+            trace_buffer_->Record(GetATCommandIndex(def), op, num_args, args_string,
+                                  CppATTraceBuffer::Result::kBadArgs, trace_buffer_->Now(), 0);
+        }
+    }
+
+    static constexpr bool IsLineEnd(char c) { return c == '\r' || c == '\n'; }
+
+    static constexpr bool IsATOpChar(char c)
+    {
+        for (char op_char : std::string_view(kATAllowedOpChars))
+        {
+            if (c == op_char)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Reads the operator character at pos, if there is one, and skips the padding after it.
+     * @param[in] message Text containing the command.
+     * @param[in] pos Index of the first character after the command.
+     * @param[out] op Operator character, or '\0' if the command ends the line.
+     * @retval Index of the first character of the arguments.
+     */
+    static size_t ReadOp(std::string_view message, size_t pos, char &op)
+    {
+        op = '\0';
+        if (pos < message.length() && !IsLineEnd(message[pos]))
+        {
+            // Don't record line returns as op to make downstream stuff simpler.
+            op = message[pos];
+            // Ignore everything we don't want to consider as an argument after the op character, up to the end of
+            // the line.
+            while (pos < message.length() &&        // Don't fall off the end of the message.
+                   !IsLineEnd(message[pos]) &&      // Don't run into the next line.
+                   !isalnum(message[pos]) &&        // Don't remove text or numbers, which are legitimate arguments.
+                   message[pos] != kArgDelimiter && // Don't ignore commas which might delimit blank args.
+                   message[pos] != '-'              // Don't accidentally remove signs!
+            )
+            {
+                pos += 1;
+            }
+        }
+        return pos;
+    }
+
+    /**
+     * @brief Returns the index of the first '\r' or '\n' at or after pos, or the length of message if there isn't one.
+     */
+    static size_t FindLineEnd(std::string_view message, size_t pos)
+    {
+        while (pos < message.length() && !IsLineEnd(message[pos]))
+        {
+            pos++;
+        }
+        return pos;
+    }
+
+    /**
+     * Consecutive calls of a command with a batch_callback, collected by ParseMessage.
+     */
+    struct Batch_t
+    {
+        const ATCommandDef_t *def = nullptr;
+        uint16_t num_invocations = 0;
+        uint16_t num_args = 0;
+        CppATInvocation_t invocations[kBatchMaxLen];
+        std::string_view args[kBatchMaxNumArgs];
+    };
+
+    /**
+     * @brief Passes the calls collected in a batch to the batch_callback of their command, and empties the batch.
+     * @retval True if the batch was empty or every call succeeded, false otherwise.
+     */
+    bool RunBatch(Batch_t &batch);
+
+    /**
+     * @brief Handles the lines of a message, starting with the AT prefix at start.
+     * @param[in] message Text containing the commands.
+     * @param[in] start Index of the first AT prefix.
+     * @param[in] batch Storage for calls waiting for a batch_callback. If nullptr, the first such call hands the rest
+     * of the message over to ParseBatchedLines().
+     * @retval True if every command succeeded, false otherwise.
+     */
+    bool ParseLines(std::string_view message, size_t start, Batch_t *batch);
+
+    /**
+     * @brief ParseLines() with batch storage. Kept out of line so that the Batch_t (several KB with the default
+     * settings) only takes up stack space in messages that call a command with a batch_callback.
+     * @param[in] message Text containing the commands.
+     * @param[in] start Index of the AT prefix of the first call to batch.
+     * @retval True if every command succeeded, false otherwise.
+     */
+    [[gnu::noinline]] bool ParseBatchedLines(std::string_view message, size_t start);
+
+    /**
+     * @brief Looks up the command of a script step, splits and checks its arguments and adds it to the script being
+     * compiled in script_store_.
+     * @retval True if the step was added, false otherwise.
+     */
+    bool CompileScriptStep(std::string_view step);
+
+    void ClearScripts()
+    {
+        if (script_store_ != nullptr)
+        {
+            script_store_->Clear();
+        }
+    }
+
+    /**
+     * @brief Destroys and deallocates a command list copied into a memory resource. Lists referenced in place or
+     * stored in at_command_list_buf_ are just dropped.
+     */
+    void FreeATCommandList();
+
+    // Non readonly handle for at_command_list_ used when it is dynamically allocated into memory.
+    ATCommandDef_t *at_command_list_ = nullptr;
+    // Memory resource requested by the user, or nullptr.
+    std::pmr::memory_resource *memory_resource_ = nullptr;
+    // Memory resource at_command_list_ was allocated from, nullptr if it wasn't allocated.
+    std::pmr::memory_resource *allocated_from_ = nullptr;
+    uint16_t num_allocated_commands_ = 0;
+    // Storage for copied AT commands when kMaxNumCommands is nonzero, used instead of dynamic memory.
+    std::array<ATCommandDef_t, kMaxNumCommands> at_command_list_buf_;
+    // Readonly handle for at_command_list_ used everywhere except where it is set.
+    const ATCommandDef_t *at_command_list_ro_ = nullptr;
+    uint16_t num_at_commands_ = 0;
+    // Optional flight recorder, nullptr when tracing is off.
+    CppATTraceBuffer *trace_buffer_ = nullptr;
+    // Optional settings profile store, nullptr when the profile commands are off.
+    CppATProfileInterface *profile_store_ = nullptr;
+    // Optional script store, nullptr when the script commands are off.
+    CppATScriptStore *script_store_ = nullptr;
+    // Latency budget monitoring.
+    Clock clock_ = SteadyClockNs;
+    OverrunHook overrun_hook_ = nullptr;
+    std::atomic<uint32_t> num_overruns_ = 0;
+};
+
+/**
+ * @brief Parser using the limits from cpp_at_settings.hh. Also owns the printf handle shared by all parser
+ * configurations.
+ */
+class CppAT : public BasicCppAT<>
+{
+public:
+    using BasicCppAT::BasicCppAT;
+
+    /**
+     * @brief printf handle used by CppAT.
+     * @param[in] Format string used for printing.
+     * @param[in] ... Variable length list of arguments.
+     * @retval The number of characters printed, or EOF if an error occurred.
+     */
+    static int cpp_at_printf(const char *format, ...);
+
+    /**
+     * @brief Prints to the active CppATOutputBuffer of the current thread if there is one, otherwise to
+     * cpp_at_printf. Used for all output from CppAT and the CPP_AT_* macros.
+     * @param[in] format Format string used for printing.
+     * @param[in] args Arguments for the format string.
+     * @retval The number of characters printed.
+     */
+    template <typename... Args>
+    static int Printf(const char *format, Args... args)
+    {
+        CppATOutputBuffer *output = CppATOutputBuffer::GetActive();
+        if (output != nullptr)
+        {
+            return output->Printf(format, args...);
+        }
+        return cpp_at_printf(format, args...);
+    }
+
+    /**
+     * @brief std::format style alternative to Printf. The format string is checked against the argument types at
+     * compile time, and the output is written straight into the active CppATOutputBuffer if there is one. Otherwise
+     * it is passed to cpp_at_printf in chunks of up to CPP_AT_FORMAT_BUFFER_LEN characters.
+     * @param[in] format Format string, e.g. "+TEMP: {:.1f}, {}".
+     * @param[in] args Arguments for the replacement fields.
+     * @retval The number of characters formatted.
+     */
+    template <typename... Args>
+    static int Format(CppATFormatString<std::type_identity_t<Args>...> format, const Args &...args)
+    {
+        CppATOutputBuffer *output = CppATOutputBuffer::GetActive();
+        if (output != nullptr)
+        {
+            return output->Format<Args...>(format, args...);
+        }
+        const CppATFormat::Arg_t arg_list[sizeof...(Args) + 1] = {CppATFormat::MakeArg(args)...};
+        char buf[CPP_AT_FORMAT_BUFFER_LEN];
+        CppATFormat::Writer_t writer = {.buf = buf, .capacity = sizeof(buf), .flush = FlushFormatBuffer};
+        CppATFormat::Format(writer, format.Get(), arg_list);
+        FlushFormatBuffer(writer);
+        return writer.total_len;
+    }
+
+private:
+    static void FlushFormatBuffer(CppATFormat::Writer_t &writer)
+    {
+        if (writer.len > 0)
+        {
+            cpp_at_printf("%.*s", static_cast<int>(writer.len), writer.buf);
+            writer.len = 0;
+        }
+    }
+};
+
+/**
+ * BasicCppAT Public Functions
+ */
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::BasicCppAT() {}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::BasicCppAT(
+    std::pmr::memory_resource *memory_resource)
+    : memory_resource_(memory_resource)
+{
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::BasicCppAT(
+    const ATCommandDef_t *at_command_list_in, uint16_t num_at_commands_in, bool at_command_list_is_static,
+    std::pmr::memory_resource *memory_resource)
+    : memory_resource_(memory_resource)
+{
+    is_valid = SetATCommandList(at_command_list_in, num_at_commands_in, at_command_list_is_static);
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::BasicCppAT(
+    BasicCppAT &&other) noexcept
+{
+    // at_help_command, at_profile_commands and at_script_commands aren't moved: their default initializers have already
+    // bound them to this parser.
+    *this = std::move(other);
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands> &
+BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::operator=(
+    BasicCppAT &&other) noexcept
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+    FreeATCommandList();
+    memory_resource_ = other.memory_resource_;
+    num_at_commands_ = other.num_at_commands_;
+    at_command_list_ro_ = other.at_command_list_ro_;
+    at_command_list_ = other.at_command_list_;
+    allocated_from_ = other.allocated_from_;
+    num_allocated_commands_ = other.num_allocated_commands_;
+    if constexpr (kMaxNumCommands > 0)
+    {
+        if (at_command_list_ == other.at_command_list_buf_.data())
+        {
+            // Stored in the table inside other, which can't be taken over. Copy it and point the string_views at the
+            // copied buffers.
+            for (uint16_t i = 0; i < num_at_commands_; i++)
+            {
+                at_command_list_buf_[i] = other.at_command_list_buf_[i];
+                at_command_list_buf_[i].command = std::string_view(at_command_list_buf_[i].command_buf);
+                at_command_list_buf_[i].help_string = std::string_view(at_command_list_buf_[i].help_string_buf);
+            }
+            at_command_list_ = at_command_list_buf_.data();
+            at_command_list_ro_ = at_command_list_;
+        }
+    }
+    is_valid = other.is_valid;
+    trace_buffer_ = other.trace_buffer_;
+    profile_store_ = other.profile_store_;
+    script_store_ = other.script_store_;
+    clock_ = other.clock_;
+    overrun_hook_ = std::move(other.overrun_hook_);
+    num_overruns_.store(other.num_overruns_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    other.at_command_list_ = nullptr;
+    other.allocated_from_ = nullptr;
+    other.num_allocated_commands_ = 0;
+    other.at_command_list_ro_ = nullptr;
+    other.num_at_commands_ = 0;
+    other.is_valid = false;
+    // The stores now belong to this parser. Scripts refer to its commands by index, and other mustn't clear them.
+    other.profile_store_ = nullptr;
+    other.script_store_ = nullptr;
+    return *this;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+bool BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::SetATCommandList(
+    const ATCommandDef_t *at_command_list_in, uint16_t num_at_commands_in, bool at_command_list_is_static)
+{
+    // There may already be a list of AT commands allocated; deallocate it to avoid a memory leak.
+    FreeATCommandList();
+    ClearScripts(); // Scripts refer to commands by index.
+    num_at_commands_ = num_at_commands_in;
+
+    // Text, binary frames and scripts must all run the same callback for a command, so only one kind may be set.
+    for (uint16_t i = 0; i < num_at_commands_in; i++)
+    {
+        if (at_command_list_in[i].raw_callback && at_command_list_in[i].batch_callback)
+        {
+            CppAT::Printf("CppAT::SetATCommandList: CommandDef %d sets both a raw_callback and a batch_callback.\r\n",
+                          i);
+            num_at_commands_ = 0;
+            return false;
+        }
+    }
+
+    // Setting AT command list from static list.
+    if (at_command_list_is_static)
+    {
+        // AT commands being passed in will stick around, use them instead of allocating new memory.
+        at_command_list_ro_ = at_command_list_in;
+        return true;
+    }
+
+    if (memory_resource_ != nullptr || (kMaxNumCommands == 0 && !CPP_AT_HEAP_FREE))
+    {
+        // Setting AT command list in memory from the user's memory resource, or from the default one (new/delete).
+        allocated_from_ = memory_resource_ != nullptr ? memory_resource_ : std::pmr::get_default_resource();
+        at_command_list_ = static_cast<ATCommandDef_t *>(
+            allocated_from_->allocate(sizeof(ATCommandDef_t) * num_at_commands_, alignof(ATCommandDef_t)));
+        std::uninitialized_value_construct_n(at_command_list_, num_at_commands_);
+        num_allocated_commands_ = num_at_commands_;
+    }
+    else if constexpr (kMaxNumCommands > 0)
+    {
+        // Setting AT command list in the table stored inside this object.
+        if (num_at_commands_ > kMaxNumCommands)
+        {
+            CppAT::Printf("CppAT::SetATCommandList: Number of commands %d exceeds maximum %d.\r\n",
+                          num_at_commands_, kMaxNumCommands);
+            num_at_commands_ = 0;
+            return false;
+        }
+        at_command_list_ = at_command_list_buf_.data();
+    }
+    else
+    {
+        CppAT::Printf("CppAT::SetATCommandList: No command table storage in heap-free build, use a static "
+                      "command list, a nonzero kMaxNumCommands or a memory resource.\r\n");
+        num_at_commands_ = 0;
+        return false;
+    }
+    // Copy in AT commands provided to SetATCommandList.
+    for (uint16_t i = 0; i < num_at_commands_in; i++)
+    {
+        const ATCommandDef_t &command_in = at_command_list_in[i];
+        at_command_list_[i] = command_in;
+    }
+    // Add in +HELP command.
+
+    // Copy string_view contents into buffers and remap string_views so that the at_command_list_ doesn't have broken
+    // references when stuff goes out of scope after initialization.
+    for (uint16_t i = 0; i < num_at_commands_; i++)
+    { // Don't do this for help command.
+        if (at_command_list_[i].command.length() > kATCommandMaxLen)
+        {
+            CppAT::Printf(
+                "CppAT::SetATCommandList: AT Command String for CommandDef %d exceeds maximum length %d.\r\n", i,
+                kATCommandMaxLen);
+            return false;
+        }
+        strncpy(at_command_list_[i].command_buf, at_command_list_[i].command.data(),
+                at_command_list_[i].command.length());
+        // Add EOS character to be extra safe.
+        at_command_list_[i].command_buf[at_command_list_[i].command.length()] = '\0';
+        // Remap string_view.
+        at_command_list_[i].command = std::string_view(at_command_list_[i].command_buf);
+
+        if (at_command_list_[i].help_string.length() > kHelpStringMaxLen)
+        {
+            CppAT::Printf(
+                "CppAT::SetATCommandList: Help String for CommandDef %d exceeds maximum length %d.\r\n", i,
+                kHelpStringMaxLen);
+            return false;
+        }
+        strncpy(at_command_list_[i].help_string_buf, at_command_list_[i].help_string.data(),
+                at_command_list_[i].help_string.length());
+        // Add EOS character to be extra safe.
+        at_command_list_[i].help_string_buf[at_command_list_[i].help_string.length()] = '\0';
+        // Remap string_view.
+        at_command_list_[i].help_string = std::string_view(at_command_list_[i].help_string_buf);
+    }
+
+    at_command_list_ro_ = at_command_list_;
+    return true;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::~BasicCppAT()
+{
+    FreeATCommandList();
+    at_command_list_ro_ = nullptr;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+uint16_t BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::GetNumATCommands()
+{
+    // Include auto-generated help, profile and script commands in count.
+    return num_at_commands_ + 1 + (profile_store_ != nullptr ? kNumProfileCommands : 0) +
+           (script_store_ != nullptr ? kNumScriptCommands : 0);
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+const typename BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::ATCommandDef_t *
+BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::LookupATCommand(
+    std::string_view command)
+{
+    if (command.length() > kATCommandMaxLen)
+    {
+        return nullptr; // Command is too long, not supported.
+    }
+    for (uint16_t i = 0; i < num_at_commands_; i++)
+    {
+        const ATCommandDef_t &def = at_command_list_ro_[i];
+        if (command.compare(0, kATCommandMaxLen, def.command) == 0)
+        {
+            return &def;
+        }
+    }
+    if (command.compare(0, kATCommandMaxLen, "+HELP") == 0)
+    {
+        return &at_help_command;
+    }
+    if (profile_store_ != nullptr)
+    {
+        for (const ATCommandDef_t &def : at_profile_commands)
+        {
+            if (command.compare(0, kATCommandMaxLen, def.command) == 0)
+            {
+                return &def;
+            }
+        }
+    }
+    if (script_store_ != nullptr)
+    {
+        for (const ATCommandDef_t &def : at_script_commands)
+        {
+            if (command.compare(0, kATCommandMaxLen, def.command) == 0)
+            {
+                return &def;
+            }
+        }
+    }
+    return nullptr;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+const typename BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::ATCommandDef_t *
+BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::GetATCommand(uint16_t index)
+{
+    if (index < num_at_commands_)
+    {
+        return &at_command_list_ro_[index];
+    }
+    if (index == num_at_commands_)
+    {
+        return &at_help_command;
+    }
+    uint16_t profile_index = index - num_at_commands_ - 1;
+    if (profile_store_ != nullptr && profile_index < kNumProfileCommands)
+    {
+        return &at_profile_commands[profile_index];
+    }
+    uint16_t script_index = profile_index - (profile_store_ != nullptr ? kNumProfileCommands : 0);
+    if (script_store_ != nullptr && script_index < kNumScriptCommands)
+    {
+        return &at_script_commands[script_index];
+    }
+    return nullptr;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+uint16_t BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::GetATCommandIndex(
+    const ATCommandDef_t *def)
+{
+    if (def >= at_command_list_ro_ && def < at_command_list_ro_ + num_at_commands_)
+    {
+        return def - at_command_list_ro_;
+    }
+    if (def == &at_help_command)
+    {
+        return num_at_commands_;
+    }
+    if (profile_store_ != nullptr && def >= at_profile_commands && def < at_profile_commands + kNumProfileCommands)
+    {
+        return num_at_commands_ + 1 + (def - at_profile_commands);
+    }
+    if (script_store_ != nullptr && def >= at_script_commands && def < at_script_commands + kNumScriptCommands)
+    {
+        return num_at_commands_ + 1 + (profile_store_ != nullptr ? kNumProfileCommands : 0) +
+               (def - at_script_commands);
+    }
+    return CppATTraceBuffer::kCommandIndexNone;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+bool BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::ParseMessage(
+    std::string_view message)
+{
+    // Every character of the message is visited a bounded number of times: the cursor only ever moves forward, and
+    // each line is scanned once for its command, once for its arguments and once for the next AT prefix.
+    std::size_t start = message.find(kATPrefix);
+    if (start == std::string_view::npos)
+    {
+        CppAT::Printf("CppAT::ParseMessage: Unable to find AT prefix in string %.*s.\r\n", message.length(),
+                      message.data());
+        return false;
+    }
+
+    return ParseLines(message, start, nullptr);
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+bool BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::CallATCommand(
+    const ATCommandDef_t *def, char op, const std::string_view args[], uint16_t num_args, std::string_view args_string)
+{
+    if (def->raw_callback)
+    {
+        return RunCallback(def, op, 0, args_string,
+                           [&]() { return def->raw_callback(*def, op, CppATArgs(args_string)); });
+    }
+    if (def->batch_callback)
+    {
+        CppATInvocation_t invocation = {
+            .op = op, .args = std::span<const std::string_view>(args, num_args), .args_string = args_string};
+        bool result = false;
+        return RunCallback(def, op, num_args, args_string,
+                           [&]()
+                           {
+                               def->batch_callback(*def, std::span<const CppATInvocation_t>(&invocation, 1),
+                                                   std::span<bool>(&result, 1));
+                               return result;
+                           });
+    }
+    if (def->callback)
+    {
+        return RunCallback(def, op, num_args, args_string,
+                           [&]() { return def->callback(*def, op, args, num_args); });
+    }
+    CppAT::Printf("CppAT: Received a call to AT command %.*s with no corresponding callback function.\r\n",
+                  def->command.length(), def->command.data());
+    return true;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+bool BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::StoreScript(
+    std::string_view name, std::string_view steps)
+{
+    if (script_store_ == nullptr)
+    {
+        CppAT::Printf("CppAT::StoreScript: No script store attached.\r\n");
+        return false;
+    }
+    if (!script_store_->BeginScript(name))
+    {
+        CppAT::Printf("CppAT::StoreScript: Unable to start script %.*s. Names must be 1 to %d characters, and at "
+                      "most %d scripts can be stored.\r\n",
+                      static_cast<int>(name.length()), name.data(), CppATScriptStore::kNameMaxLen,
+                      CppATScriptStore::kMaxNumScripts);
+        return false;
+    }
+    while (true)
+    {
+        size_t step_end = steps.find(kScriptStepDelimiter);
+        if (!CompileScriptStep(steps.substr(0, step_end)))
+        {
+            script_store_->AbortScript();
+            return false;
+        }
+        if (step_end == std::string_view::npos)
+        {
+            break;
+        }
+        steps.remove_prefix(step_end + 1);
+    }
+    return script_store_->CommitScript();
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+bool BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::RunScript(
+    std::string_view name, uint16_t *failed_step)
+{
+    std::span<const CppATScriptStore::Step_t> steps =
+        script_store_ != nullptr ? script_store_->GetScript(name) : std::span<const CppATScriptStore::Step_t>();
+    if (steps.empty())
+    {
+        CppAT::Printf("CppAT::RunScript: Unable to find script %.*s.\r\n", name.length(), name.data());
+        return false;
+    }
+    for (uint16_t i = 0; i < steps.size(); i++)
+    {
+        // Everything was looked up and split when the script was stored, so go straight to the callback.
+        const CppATScriptStore::Step_t &step = steps[i];
+        const ATCommandDef_t *def = GetATCommand(step.command_index);
+        if (!CallATCommand(def, step.op, script_store_->GetArgs(step), step.num_args, step.args_string) &&
+            !step.ignore_failure)
+        {
+            if (failed_step != nullptr)
+            {
+                *failed_step = i;
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * BasicCppAT Private Functions
+ */
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+bool BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::ParseLines(
+    std::string_view message, size_t start, Batch_t *batch)
+{
+    while (start != std::string_view::npos)
+    {
+        size_t line_start = start;
+        start += kATPrefixLen; // Start after the AT prefix.
+
+        // Command is everything between AT prefix and the first punctuation or newline.
+        size_t command_end = start;
+        while (command_end < message.length() && !IsATOpChar(message[command_end]))
+        {
+            command_end++;
+        }
+        std::string_view command = message.substr(start, command_end - start);
+        const ATCommandDef_t *def = command.length() > 0 ? LookupATCommand(command) : nullptr;
+        // Run the calls batched so far before anything else happens, so that commands run in message order.
+        if (batch != nullptr && def != batch->def && !RunBatch(*batch))
+        {
+            return false;
+        }
+        if (command.length() == 0)
+        {
+            CppAT::Printf("CppAT::ParseMessage: Can't parse 0 length command in string %.*s.\r\n",
+                          message.length(), message.data());
+            if (trace_buffer_ != nullptr)
+            {
+                trace_buffer_->Record(CppATTraceBuffer::kCommandIndexNone, '\0', 0, command,
+                                      CppATTraceBuffer::Result::kUnknownCommand, trace_buffer_->Now(), 0);
+            }
+            return false;
+        }
+        if (def == nullptr)
+        {
+            CppAT::Printf("CppAT::ParseMessage: Unable to match AT command %.*s.\r\n", command.length(),
+                          command.data());
+            if (trace_buffer_ != nullptr)
+            {
+                trace_buffer_->Record(CppATTraceBuffer::kCommandIndexNone, '\0', 0, command,
+                                      CppATTraceBuffer::Result::kUnknownCommand, trace_buffer_->Now(), 0);
+            }
+            return false;
+        }
+
+        // Parse out the arguments
+        // Look for operator (non-alphanumeric char at end of command).
+        char op;
+        start = ReadOp(message, command_end, op);
+
+        if (def->batch_callback)
+        {
+            // Batched calls keep views into the message, so their arguments are split but not copied.
+            size_t line_end = FindLineEnd(message, start);
+            std::string_view args_string = message.substr(start, line_end - start);
+            size_t num_args =
+                args_string.empty() ? 0 : std::count(args_string.begin(), args_string.end(), kArgDelimiter) + 1;
+            if (num_args < def->min_args || num_args > def->max_args || num_args > kBatchMaxNumArgs)
+            {
+                if (batch != nullptr && !RunBatch(*batch))
+                {
+                    return false;
+                }
+                CppAT::Printf("CppAT::ParseMessage: Received incorrect number of args for command %.*s: got %zu, "
+                              "expected minimum %d, maximum %d.\r\n",
+                              command.length(), command.data(), num_args, def->min_args,
+                              std::min<uint16_t>(def->max_args, kBatchMaxNumArgs));
+                TraceBadArgs(def, op, std::min<size_t>(num_args, UINT16_MAX), args_string);
+                return false;
+            }
+            if (batch == nullptr)
+            {
+                // Only messages that batch pay for the batch storage. The line is parsed again from there.
+                return ParseBatchedLines(message, line_start);
+            }
+            if (batch->num_invocations == kBatchMaxLen || batch->num_args + num_args > kBatchMaxNumArgs)
+            {
+                if (!RunBatch(*batch))
+                {
+                    return false;
+                }
+            }
+            std::string_view *args = batch->args + batch->num_args;
+            CppATArgs split_args(args_string);
+            for (size_t i = 0; i < num_args; i++)
+            {
+                split_args.Next(args[i]);
+            }
+            batch->def = def;
+            batch->invocations[batch->num_invocations++] = {
+                .op = op, .args = std::span<const std::string_view>(args, num_args), .args_string = args_string};
+            batch->num_args += num_args;
+            start = message.find(kATPrefix, line_end);
+            continue;
+        }
+
+        if (def->raw_callback)
+        {
+            // Raw callbacks pull their own arguments, so don't split or copy them here.
+            size_t line_end = FindLineEnd(message, start);
+            std::string_view args_string = message.substr(start, line_end - start);
+            if (!RunCallback(def, op, 0, args_string,
+                             [&]() { return def->raw_callback(*def, op, CppATArgs(args_string)); }))
+            {
+                return false;
+            }
+            start = message.find(kATPrefix, line_end);
+            continue;
+        }
+
+        // Args are everything between command and carriage return or newline. Split and copy them in one pass.
+        char args_str_buf_list[kMaxNumArgs][kArgMaxLen + 1];
+        std::string_view args_list[kMaxNumArgs];
+        uint16_t num_args = 0;
+        size_t arg_start = start;
+        size_t pos = start;
+        while (true)
+        {
+            bool at_line_end = pos >= message.length() || IsLineEnd(message[pos]);
+            if (!at_line_end && message[pos] != kArgDelimiter)
+            {
+                pos++;
+                continue;
+            }
+            if (at_line_end && pos == start)
+            {
+                break; // No arguments. A blank argument is only counted after a delimiter.
+            }
+            if (num_args >= kMaxNumArgs)
+            {
+                CppAT::Printf("CppAT::ParseMessage: Too many arguments.\r\n");
+                TraceBadArgs(def, op, num_args, message.substr(start, FindLineEnd(message, pos) - start));
+                return false;
+            }
+            size_t arg_len = pos - arg_start;
+            if (arg_len > kArgMaxLen)
+            {
+                CppAT::Printf("CppAT::Parsemessage: Argument %d is too long, must be <=%d characters.\r\n",
+                              num_args, kArgMaxLen);
+                TraceBadArgs(def, op, num_args, message.substr(start, FindLineEnd(message, pos) - start));
+                return false;
+            }
+            memcpy(args_str_buf_list[num_args], &message[arg_start], arg_len);
+            args_str_buf_list[num_args][arg_len] = '\0'; // make argument safe to process into a string view
+            args_list[num_args] = std::string_view(args_str_buf_list[num_args], arg_len);
+            num_args++;
+            if (at_line_end)
+            {
+                break;
+            }
+            pos++; // Skip the delimiter.
+            arg_start = pos;
+        }
+        std::string_view args_string = message.substr(start, pos - start);
+
+        if ((num_args < def->min_args) || (num_args > def->max_args))
+        {
+            CppAT::Printf(
+                "CppAT::ParseMessage: Received incorrect number of args for command %.*s: got %d, expected minimum %d, "
+                "maximum %d.\r\n",
+                command.length(), command.data(), num_args, def->min_args, def->max_args);
+            TraceBadArgs(def, op, num_args, args_string);
+            return false;
+        }
+        if (def->callback)
+        {
+            bool result = RunCallback(def, op, num_args, args_string,
+                                      [&]() { return def->callback(*def, op, args_list, num_args); });
+            if (!result)
+            {
+                if (op == '\0')
+                {
+                    op = '_'; // Replace null op with underscore for printing.
+                }
+                // CppAT::Printf("CppAT::ParseMessage: Call to AT Command %.*s with op '%c' and args %.*s failed.\r\n",
+                //               command.length(), command.data(), op, args_string.length(), args_string.data());
+                return false;
+            }
+        }
+        else
+        {
+            CppAT::Printf(
+                "CppAT::ParseMessage: Received a call to AT command %.*s with no corresponding callback function.\r\n",
+                command.length(), command.data());
+        }
+
+        // Look for the next AT command after the end of this line, so arguments containing "AT" aren't run.
+        start = message.find(kATPrefix, pos);
+    }
+
+    if (batch != nullptr)
+    {
+        return RunBatch(*batch);
+    }
+    return true;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+bool BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::ParseBatchedLines(
+    std::string_view message, size_t start)
+{
+    Batch_t batch;
+    return ParseLines(message, start, &batch);
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+bool BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::RunBatch(Batch_t &batch)
+{
+    const ATCommandDef_t *def = batch.def;
+    uint16_t num_invocations = batch.num_invocations;
+    batch.def = nullptr;
+    batch.num_invocations = 0;
+    batch.num_args = 0;
+    if (num_invocations == 0)
+    {
+        return true;
+    }
+
+    bool results[kBatchMaxLen] = {}; // Calls the callback doesn't report on count as failed.
+    uint64_t timestamp_ns = trace_buffer_ != nullptr ? trace_buffer_->Now() : 0;
+    uint64_t start_ns = def->latency_budget_us > 0 ? clock_() : 0;
+    def->batch_callback(*def, std::span<const CppATInvocation_t>(batch.invocations, num_invocations),
+                        std::span<bool>(results, num_invocations));
+    if (def->latency_budget_us > 0)
+    {
+        // The budget is per call, so a batch gets one budget for each call in it.
+        uint64_t duration_us = (clock_() - start_ns) / 1000;
+        if (duration_us > static_cast<uint64_t>(def->latency_budget_us) * num_invocations)
+        {
+            num_overruns_.fetch_add(1, std::memory_order_relaxed);
+            if (overrun_hook_)
+            {
+                overrun_hook_(*def, duration_us);
+            }
+        }
+    }
+
+    bool all_succeeded = true;
+    uint64_t duration_ns = trace_buffer_ != nullptr ? (trace_buffer_->Now() - timestamp_ns) / num_invocations : 0;
+    for (uint16_t i = 0; i < num_invocations; i++)
+    {
+        all_succeeded &= results[i];
+        if (trace_buffer_ != nullptr)
+        {
+            const CppATInvocation_t &invocation = batch.invocations[i];
+            trace_buffer_->Record(GetATCommandIndex(def), invocation.op, invocation.args.size(), invocation.args_string,
+                                  results[i] ? CppATTraceBuffer::Result::kOK : CppATTraceBuffer::Result::kError,
+                                  timestamp_ns, duration_ns);
+        }
+    }
+    return all_succeeded;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+void BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::FreeATCommandList()
+{
+    if (allocated_from_ != nullptr)
+    {
+        // Callbacks may own captured state (std::function, or CppATInplaceFunction holding non-trivial captures), so
+        // each entry is destroyed even when the resource is a monotonic arena that ignores deallocate().
+        std::destroy_n(at_command_list_, num_allocated_commands_);
+        allocated_from_->deallocate(at_command_list_, sizeof(ATCommandDef_t) * num_allocated_commands_,
+                                    alignof(ATCommandDef_t));
+    }
+    at_command_list_ = nullptr;
+    allocated_from_ = nullptr;
+    num_allocated_commands_ = 0;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+bool BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::ATHelpCallback(
+    const ATCommandDef_t &, char, const std::string_view[], uint16_t)
+{
+    CppAT::Printf("AT Command Help Menu:\r\n");
+    uint16_t num_commands = GetNumATCommands();
+    for (uint16_t i = 0; i < num_commands; i++)
+    {
+        if (i == num_at_commands_)
+        {
+            continue; // Don't list AT+HELP itself.
+        }
+        // Reference, copying callbacks may allocate.
+        const ATCommandDef_t &at_command = *GetATCommand(i);
+        CppAT::Printf("%.*s: \r\n", at_command.command.length(), at_command.command.data());
+        if (at_command.help_callback)
+        {
+            // Call the provided help callback function.
+            at_command.help_callback();
+        }
+        else
+        {
+            // Print the help string.
+            CppAT::Printf("\t%.*s\r\n", at_command.help_string.length(), at_command.help_string.data());
+        }
+    }
+    return true;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+bool BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::ATProfileCallback(
+    const ATCommandDef_t &def, char, const std::string_view[], uint16_t)
+{
+    bool result = true;
+    if (&def == &at_profile_commands[0])
+    {
+        result = profile_store_->Save();
+    }
+    else if (&def == &at_profile_commands[1])
+    {
+        result = profile_store_->Restore();
+    }
+    else
+    {
+        profile_store_->FactoryReset();
+    }
+    CppAT::Printf(result ? "OK\r\n" : "ERROR\r\n");
+    return result;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+bool BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::CompileScriptStep(
+    std::string_view step)
+{
+    while (!step.empty() && step[0] == ' ')
+    {
+        step.remove_prefix(1);
+    }
+    CppATScriptStore::Step_t compiled;
+    if (!step.empty() && step[0] == kScriptIgnoreFailurePrefix)
+    {
+        compiled.ignore_failure = true;
+        step.remove_prefix(1);
+    }
+    size_t command_end = 0;
+    while (command_end < step.length() && !IsATOpChar(step[command_end]))
+    {
+        command_end++;
+    }
+    std::string_view command = step.substr(0, command_end);
+    const ATCommandDef_t *def = command.length() > 0 ? LookupATCommand(command) : nullptr;
+    if (def == nullptr || (def >= at_script_commands && def < at_script_commands + kNumScriptCommands))
+    {
+        // Scripts can't store or run other scripts.
+        CppAT::Printf("CppAT::StoreScript: Unable to match AT command %.*s.\r\n", command.length(), command.data());
+        return false;
+    }
+    compiled.command_index = GetATCommandIndex(def);
+    std::string_view args_string = step.substr(ReadOp(step, command_end, compiled.op));
+
+    // Split the arguments the way ParseMessage would for this kind of callback. Raw callbacks split their own.
+    constexpr uint16_t kMaxNumSplitArgs = std::max(kMaxNumArgs, kBatchMaxNumArgs);
+    std::string_view args[kMaxNumSplitArgs];
+    size_t num_args = 0;
+    if (!def->raw_callback)
+    {
+        uint16_t max_args = std::min(def->max_args, def->batch_callback ? kBatchMaxNumArgs : kMaxNumArgs);
+        CppATArgs split_args(args_string);
+        for (std::string_view arg; split_args.Next(arg); num_args++)
+        {
+            if (num_args == max_args || (!def->batch_callback && arg.length() > kArgMaxLen))
+            {
+                num_args = SIZE_MAX;
+                break;
+            }
+            args[num_args] = arg;
+        }
+        if (num_args < def->min_args || num_args > max_args)
+        {
+            CppAT::Printf("CppAT::StoreScript: Wrong number or length of args for command %.*s: expected minimum %d, "
+                          "maximum %d of up to %d characters.\r\n",
+                          command.length(), command.data(), def->min_args, max_args, kArgMaxLen);
+            return false;
+        }
+    }
+    if (!script_store_->AddStep(compiled, args_string, std::span<const std::string_view>(args, num_args)))
+    {
+        CppAT::Printf("CppAT::StoreScript: Not enough room in the script store for step %.*s.\r\n",
+                      static_cast<int>(step.length()), step.data());
+        return false;
+    }
+    return true;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+bool BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::ATScriptCallback(
+    const ATCommandDef_t &, char op, CppATArgs args)
+{
+    bool result = false;
+    std::string_view name;
+    if (op == '?')
+    {
+        for (uint16_t i = 0; i < script_store_->GetNumScripts(); i++)
+        {
+            std::string_view script_name = script_store_->GetScriptName(i);
+            CppAT::Printf("+SCRIPT: %.*s,%d\r\n", script_name.length(), script_name.data(),
+                          script_store_->GetNumSteps(i));
+        }
+        result = true;
+    }
+    else if (op == '=' && args.Next(name))
+    {
+        // The steps contain delimiters of their own, so they are everything after the name.
+        result = args.HasNext() ? StoreScript(name, args.GetRemaining()) : script_store_->RemoveScript(name);
+    }
+    CppAT::Printf(result ? "OK\r\n" : "ERROR\r\n");
+    return result;
+}
+
+template <uint16_t CommandMaxLen, uint16_t MaxNumArgs, uint16_t ArgMaxLen, uint16_t HelpStringMaxLen,
+          uint16_t MaxNumCommands>
+bool BasicCppAT<CommandMaxLen, MaxNumArgs, ArgMaxLen, HelpStringMaxLen, MaxNumCommands>::ATRunCallback(
+    const ATCommandDef_t &, char op, const std::string_view args[], uint16_t)
+{
+    uint16_t failed_step = UINT16_MAX;
+    bool result = op == '=' && RunScript(args[0], &failed_step);
+    if (failed_step != UINT16_MAX)
+    {
+        CppAT::Printf("+RUN: %d\r\n", failed_step);
+    }
+    CppAT::Printf(result ? "OK\r\n" : "ERROR\r\n");
+    return result;
+}
+
+// The default configuration is instantiated once in cpp_at.cc.
+extern template class BasicCppAT<>;
+
+/** CppAT Convenience Macros */
+// NOTE: do {} while (false) structure is used on standalone multi-line macros to create a single block and force use of
+// a semicolon after calling the macro.
+
+#define CPP_AT_HAS_ARG(n) (num_args > (n) && !args[(n)].empty())
+
+#define CPP_AT_TRY_ARG2NUM(args_index, num)                                   \
+    do                                                                        \
+    {                                                                         \
+        if (!CppAT::ArgToNum(args[(args_index)], (num)))                      \
+        {                                                                     \
+            CppAT::Printf("Error converting argument %d.\r\n", (args_index)); \
+            return false;                                                     \
+        }                                                                     \
+    } while (false)
+
+#define CPP_AT_TRY_ARG2NUM_BASE(args_index, num, base)                                             \
+    do                                                                                             \
+    {                                                                                              \
+        if (!CppAT::ArgToNum(args[(args_index)], (num), (base)))                                   \
+        {                                                                                          \
+            CppAT::Printf("Error converting argument %d with base %d.\r\n", (args_index), (base)); \
+            return false;                                                                          \
+        }                                                                                          \
+    } while (false)
+
+// Decodes args[args_index] through args[num_args - 1] into a std::span (or array) of numbers, which must have exactly
+// one element per argument.
+#define CPP_AT_TRY_ARGS2NUMS(args_index, numbers)                                                                  \
+    do                                                                                                             \
+    {                                                                                                              \
+        std::span numbers_span_(numbers);                                                                          \
+        uint16_t num_values_ = num_args > (args_index) ? num_args - (args_index) : 0;                              \
+        if (num_values_ != numbers_span_.size())                                                                   \
+        {                                                                                                          \
+            CppAT::Printf("Expected %d values, got %d.\r\n", static_cast<int>(numbers_span_.size()), num_values_); \
+            return false;                                                                                          \
+        }                                                                                                          \
+        auto result_ = CppAT::ArgsToNums(args + (args_index), num_values_, numbers_span_);                         \
+        if (result_.num_errors > 0)                                                                                \
+        {                                                                                                          \
+            int error_index_ = (args_index) + static_cast<int>(result_.first_error_index);                         \
+            CppAT::Printf("Error converting argument %d.\r\n", error_index_);                                      \
+            return false;                                                                                          \
+        }                                                                                                          \
+    } while (false)
+
+// Decodes args[args_index] as hex or base64 into a std::span (or array) of uint8_t, and sets num_bytes to the number
+// of bytes decoded.
+#define CPP_AT_TRY_HEXARG2BYTES(args_index, bytes, num_bytes)                                         \
+    do                                                                                                \
+    {                                                                                                 \
+        if (CppAT::HexArgToBytes(args[(args_index)], (bytes), (num_bytes)) != CppAT::ArgError::kNone) \
+        {                                                                                             \
+            CppAT::Printf("Error decoding hex argument %d.\r\n", (args_index));                       \
+            return false;                                                                             \
+        }                                                                                             \
+    } while (false)
+
+#define CPP_AT_TRY_BASE64ARG2BYTES(args_index, bytes, num_bytes)                                         \
+    do                                                                                                   \
+    {                                                                                                    \
+        if (CppAT::Base64ArgToBytes(args[(args_index)], (bytes), (num_bytes)) != CppAT::ArgError::kNone) \
+        {                                                                                                \
+            CppAT::Printf("Error decoding base64 argument %d.\r\n", (args_index));                       \
+            return false;                                                                                \
+        }                                                                                                \
+    } while (false)
+
+#define CPP_AT_SUCCESS()         \
+    do                           \
+    {                            \
+        CppAT::Printf("OK\r\n"); \
+        return true;             \
+    } while (false)
+
+#define CPP_AT_SILENT_SUCCESS() return true
+
+#define CPP_AT_ERROR(format, ...)                                         \
+    do                                                                    \
+    {                                                                     \
+        CppAT::Printf("ERROR " format "\r\n" __VA_OPT__(, ) __VA_ARGS__); \
+        return false;                                                     \
+    } while (false)
+
+// Callbacks rarely use every parameter, so the callback macros mark them [[maybe_unused]] to keep -Wextra quiet.
+#define CPP_AT_CALLBACK(callback_name)                                                              \
+    bool callback_name([[maybe_unused]] const CppAT::ATCommandDef_t &def, [[maybe_unused]] char op, \
+                       [[maybe_unused]] const std::string_view args[], [[maybe_unused]] uint16_t num_args)
+
+// Callback for a parser configured with custom command or help string lengths, e.g. BasicCppAT<16, 2, 32, 64>.
+#define CPP_AT_CALLBACK_FOR(parser_type, callback_name)                                                   \
+    bool callback_name([[maybe_unused]] const parser_type::ATCommandDef_t &def, [[maybe_unused]] char op, \
+                       [[maybe_unused]] const std::string_view args[], [[maybe_unused]] uint16_t num_args)
+
+// Callback that pulls its own arguments from a CppATArgs range, set as the raw_callback of an ATCommandDef_t.
+#define CPP_AT_RAW_CALLBACK(callback_name) \
+    bool callback_name([[maybe_unused]] const CppAT::ATCommandDef_t &def, [[maybe_unused]] char op, CppATArgs args)
+
+// Callback that handles consecutive calls of a command at once, set as the batch_callback of an ATCommandDef_t. Must
+// set results[i] to the result of invocations[i].
+#define CPP_AT_BATCH_CALLBACK(callback_name)                              \
+    void callback_name([[maybe_unused]] const CppAT::ATCommandDef_t &def, \
+                       std::span<const CppATInvocation_t> invocations, std::span<bool> results)
+
+#define CPP_AT_HELP_CALLBACK(callback_name) void callback_name()
+
+// NOTE: Member callbacks are bound with lambdas that capture a single pointer instead of std::bind, so that they fit
+// inside the small buffer of std::function (or CppATInplaceFunction) and binding never allocates.
+#define CPP_AT_BIND_MEMBER_CALLBACK(callback, instance)                                                      \
+    [instance_ptr = &(instance)](const auto &def, char op, const std::string_view args[], uint16_t num_args) \
+    { return (instance_ptr->*(&callback))(def, op, args, num_args); }
+
+#define CPP_AT_BIND_MEMBER_HELP_CALLBACK(callback, instance) \
+    [instance_ptr = &(instance)]() { (instance_ptr->*(&callback))(); }
+
+#define CPP_AT_CMD_PRINTF(format, ...) \
+    CppAT::Printf("%s" format "\r\n", def.command.data() __VA_OPT__(, ) __VA_ARGS__)
+
+#define CPP_AT_PRINTF(format, ...) \
+    CppAT::Printf(format __VA_OPT__(, ) __VA_ARGS__)
+
+// std::format style versions of the macros above, checked at compile time. E.g. CPP_AT_CMD_FORMAT("={},{:.2f}", a, b).
+#define CPP_AT_CMD_FORMAT(format, ...) CppAT::Format("{}" format "\r\n", def.command __VA_OPT__(, ) __VA_ARGS__)
+
+#define CPP_AT_FORMAT(format, ...) CppAT::Format(format __VA_OPT__(, ) __VA_ARGS__)
+
+#define CPP_AT_FORMAT_ERROR(format, ...)                                  \
+    do                                                                    \
+    {                                                                     \
+        CppAT::Format("ERROR " format "\r\n" __VA_OPT__(, ) __VA_ARGS__); \
+        return false;                                                     \
+    } while (false)
 
 #endif /* _CPP_AT_HH_ */
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "cpp_at_binary.hh"
+
+#include <charconv> // for std::to_chars
+#include <cstdio>   // for snprintf
+#include <cstdlib>  // for strtof
+#include <cstring>  // for memcpy
+#include <limits>
+
+namespace
+{
+
+uint16_t ReadU16(const char *data)
+{
+    return static_cast<uint8_t>(data[0]) | static_cast<uint16_t>(static_cast<uint8_t>(data[1])) << 8;
+}
+
+uint64_t ReadLittleEndian(std::string_view value)
+{
+    uint64_t result = 0;
+    for (size_t i = value.length(); i > 0; i--)
+    {
+        result = result << 8 | static_cast<uint8_t>(value[i - 1]);
+    }
+    return result;
+}
+
+void WriteLittleEndian(uint8_t *dest, uint64_t value, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        dest[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+bool IsIntLen(size_t len) { return len == 1 || len == 2 || len == 4 || len == 8; }
+
+} // namespace
+
+/**
+ * CppATBinary Public Functions
+ */
+
+size_t CppATBinary::GetFrameLen(std::string_view data)
+{
+    if (data.length() < kLengthFieldEnd)
+    {
+        return 0;
+    }
+    return kLengthFieldEnd + ReadU16(data.data() + 1);
+}
+
+bool CppATBinary::ReadHeader(std::string_view frame, Header_t &header, std::string_view &args)
+{
+    if (frame.length() < kHeaderLen || static_cast<uint8_t>(frame[0]) != kLeadByte ||
+        GetFrameLen(frame) != frame.length())
+    {
+        return false;
+    }
+    header.command_index = ReadU16(frame.data() + 3);
+    header.op = frame[5];
+    header.num_args = static_cast<uint8_t>(frame[6]);
+    args = frame.substr(kHeaderLen);
+    return true;
+}
+
+bool CppATBinary::ReadArg(std::string_view &args, ArgType &type, std::string_view &value)
+{
+    if (args.length() < kArgHeaderLen)
+    {
+        return false;
+    }
+    size_t len = ReadU16(args.data() + 1);
+    if (args.length() < kArgHeaderLen + len)
+    {
+        return false;
+    }
+    type = static_cast<ArgType>(args[0]);
+    value = args.substr(kArgHeaderLen, len);
+    args.remove_prefix(kArgHeaderLen + len);
+    return true;
+}
+
+size_t CppATBinary::ArgToText(ArgType type, std::string_view value, char *buf, size_t buf_len)
+{
+    std::to_chars_result result = {.ptr = nullptr, .ec = std::errc::invalid_argument};
+    switch (type)
+    {
+    case ArgType::kText:
+        if (value.length() > buf_len)
+        {
+            return SIZE_MAX;
+        }
+        memcpy(buf, value.data(), value.length());
+        return value.length();
+    case ArgType::kInt:
+        if (IsIntLen(value.length()))
+        {
+            // Sign extend from the top bit of the encoded value.
+            uint8_t shift = 64 - 8 * value.length();
+            int64_t number = static_cast<int64_t>(ReadLittleEndian(value) << shift) >> shift;
+            result = std::to_chars(buf, buf + buf_len, number);
+        }
+        break;
+    case ArgType::kUint:
+        if (IsIntLen(value.length()))
+        {
+            result = std::to_chars(buf, buf + buf_len, ReadLittleEndian(value));
+        }
+        break;
+    case ArgType::kFloat:
+        if (value.length() == sizeof(float))
+        {
+            uint32_t bits = static_cast<uint32_t>(ReadLittleEndian(value));
+            float number;
+            memcpy(&number, &bits, sizeof(number));
+#if defined(__cpp_lib_to_chars)
+            result = std::to_chars(buf, buf + buf_len, number);
+#else
+            // No floating point std::to_chars (e.g. GCC 10), print the fewest digits that round trip instead.
+            char float_buf[32];
+            int len = 0;
+            for (int precision = 1; precision <= std::numeric_limits<float>::max_digits10; precision++)
+            {
+                len = snprintf(float_buf, sizeof(float_buf), "%.*g", precision, static_cast<double>(number));
+                if (strtof(float_buf, nullptr) == number)
+                {
+                    break;
+                }
+            }
+            if (len > 0 && static_cast<size_t>(len) <= buf_len)
+            {
+                memcpy(buf, float_buf, len);
+                result = {.ptr = buf + len, .ec = std::errc()};
+            }
+#endif
+        }
+        break;
+    }
+    return result.ec == std::errc() ? result.ptr - buf : SIZE_MAX;
+}
+
+/**
+ * CppATBinary::Writer Public Functions
+ */
+
+CppATBinary::Writer::Writer(std::span<uint8_t> buf, uint16_t command_index, char op) : buf_(buf)
+{
+    if (buf_.size() < kHeaderLen)
+    {
+        is_valid_ = false;
+        return;
+    }
+    buf_[0] = kLeadByte;
+    WriteLittleEndian(&buf_[3], command_index, sizeof(command_index));
+    buf_[5] = static_cast<uint8_t>(op);
+    buf_[6] = 0; // num_args
+    len_ = kHeaderLen;
+    WriteLittleEndian(&buf_[1], len_ - kLengthFieldEnd, 2);
+}
+
+bool CppATBinary::Writer::AddText(std::string_view text)
+{
+    return AddArg(ArgType::kText, reinterpret_cast<const uint8_t *>(text.data()), text.length());
+}
+
+bool CppATBinary::Writer::AddInt(int64_t value)
+{
+    uint8_t bytes[sizeof(value)];
+    size_t len = 1;
+    while (len < sizeof(value) && (value < -(int64_t(1) << (8 * len - 1)) || value >= int64_t(1) << (8 * len - 1)))
+    {
+        len *= 2;
+    }
+    WriteLittleEndian(bytes, static_cast<uint64_t>(value), len);
+    return AddArg(ArgType::kInt, bytes, len);
+}
+
+bool CppATBinary::Writer::AddUint(uint64_t value)
+{
+    uint8_t bytes[sizeof(value)];
+    size_t len = 1;
+    while (len < sizeof(value) && value >> (8 * len) != 0)
+    {
+        len *= 2;
+    }
+    WriteLittleEndian(bytes, value, len);
+    return AddArg(ArgType::kUint, bytes, len);
+}
+
+bool CppATBinary::Writer::AddFloat(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint8_t bytes[sizeof(bits)];
+    WriteLittleEndian(bytes, bits, sizeof(bits));
+    return AddArg(ArgType::kFloat, bytes, sizeof(bytes));
+}
+
+std::string_view CppATBinary::Writer::GetFrame() const
+{
+    if (!is_valid_)
+    {
+        return {};
+    }
+    return std::string_view(reinterpret_cast<const char *>(buf_.data()), len_);
+}
+
+/**
+ * CppATBinary::Writer Private Functions
+ */
+
+bool CppATBinary::Writer::AddArg(ArgType type, const uint8_t *value, size_t len)
+{
+    if (!is_valid_ || buf_[6] == UINT8_MAX || len > UINT16_MAX || len_ + kArgHeaderLen + len > buf_.size() ||
+        len_ + kArgHeaderLen + len - kLengthFieldEnd > UINT16_MAX)
+    {
+        is_valid_ = false;
+        return false;
+    }
+    buf_[len_] = static_cast<uint8_t>(type);
+    WriteLittleEndian(&buf_[len_ + 1], len, 2);
+    if (len > 0)
+    {
+        memcpy(&buf_[len_ + kArgHeaderLen], value, len);
+    }
+    len_ += kArgHeaderLen + len;
+    buf_[6]++;
+    WriteLittleEndian(&buf_[1], len_ - kLengthFieldEnd, 2);
+    return true;
+}
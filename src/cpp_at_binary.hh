@@ -0,0 +1,249 @@
+#ifndef _CPP_AT_BINARY_HH_
+#define _CPP_AT_BINARY_HH_
+
+#include <algorithm> // for std::min
+#include <cstring>   // for memchr, memcpy
+#include <span>
+#include <string_view>
+#include "cpp_at.hh"
+#include "cpp_at_trace.hh"
+#include "stdint.h"
+
+/**
+ * @brief Compact binary command frames for machine-to-machine links. A frame starts with kLeadByte, which never
+ * starts a text AT line, so both can be sent over the same port. Frames select a command by its index instead of its
+ * name and carry length-prefixed, typed arguments, so no prefix search, name matching or comma splitting is needed.
+ *
+ * Frame layout, multi-byte fields little endian:
+ *   kLeadByte | length (u16, bytes after this field) | command index (u16) | op (char, '\0' for none) | num_args (u8)
+ * followed by num_args arguments of:
+ *   type (ArgType) | length (u16) | value
+ *
+ * The command index is the one used by GetATCommand() and the flight recorder: commands in list order, then AT+HELP.
+ *
+ * Frames are opt-in: the parser itself only reads text, and a transport that accepts frames runs them with
+ * CppATParseBinaryMessage() or CppATParseMessageWithFrames().
+ */
+class CppATBinary
+{
+public:
+    static constexpr uint8_t kLeadByte = 0xFE;
+    static constexpr uint16_t kHeaderLen = 7;      // Lead byte through num_args.
+    static constexpr uint16_t kArgHeaderLen = 3;   // Type and length of an argument.
+    static constexpr uint16_t kLengthFieldEnd = 3; // The frame length counts the bytes after the length field.
+
+    enum class ArgType : uint8_t
+    {
+        kText = 0,  // Argument text, passed to handlers as is.
+        kInt = 1,   // Signed integer, 1, 2, 4 or 8 bytes.
+        kUint = 2,  // Unsigned integer, 1, 2, 4 or 8 bytes.
+        kFloat = 3, // IEEE 754 single precision float, 4 bytes.
+    };
+
+    struct Header_t
+    {
+        uint16_t command_index = 0;
+        char op = '\0';
+        uint8_t num_args = 0;
+    };
+
+    /**
+     * @brief Returns the length of the frame at the start of data, so a transport knows how many bytes to collect.
+     * @param[in] data Received bytes starting with kLeadByte.
+     * @retval Total length of the frame including its header, or 0 if data is too short to tell.
+     */
+    static size_t GetFrameLen(std::string_view data);
+
+    /**
+     * @brief Decodes the header of a complete frame.
+     * @param[in] frame Frame starting with kLeadByte, exactly GetFrameLen() bytes long.
+     * @param[out] header Decoded header.
+     * @param[out] args Encoded arguments that follow the header.
+     * @retval True if the header is well formed, false otherwise.
+     */
+    static bool ReadHeader(std::string_view frame, Header_t &header, std::string_view &args);
+
+    /**
+     * @brief Pulls the next argument from the encoded arguments of a frame.
+     * @param[in,out] args Encoded arguments, advanced past the argument.
+     * @param[out] type Type of the argument.
+     * @param[out] value Encoded value of the argument.
+     * @retval True if an argument was read, false if args is truncated.
+     */
+    static bool ReadArg(std::string_view &args, ArgType &type, std::string_view &value);
+
+    /**
+     * @brief Converts an argument to the text a handler would have received in a text AT command, e.g. "-12".
+     * @param[in] type Type of the argument.
+     * @param[in] value Encoded value of the argument.
+     * @param[out] buf Destination for the text. Not null terminated.
+     * @param[in] buf_len Size of buf.
+     * @retval Length of the text, or SIZE_MAX if the value is malformed or doesn't fit in buf.
+     */
+    static size_t ArgToText(ArgType type, std::string_view value, char *buf, size_t buf_len);
+
+    /**
+     * @brief Builds a frame, e.g. on the host side.
+     */
+    class Writer
+    {
+    public:
+        /**
+         * @brief Starts a frame.
+         * @param[out] buf Destination for the frame.
+         * @param[in] command_index Index of the command to call.
+         * @param[in] op Operator character, e.g. '=' or '?', or '\0' for none.
+         */
+        Writer(std::span<uint8_t> buf, uint16_t command_index, char op = '\0');
+
+        bool AddText(std::string_view text);
+        bool AddInt(int64_t value);   // Encoded in the fewest bytes that hold the value.
+        bool AddUint(uint64_t value); // Encoded in the fewest bytes that hold the value.
+        bool AddFloat(float value);
+
+        /**
+         * @brief Returns the finished frame, or an empty string_view if something didn't fit.
+         */
+        std::string_view GetFrame() const;
+
+    private:
+        bool AddArg(ArgType type, const uint8_t *value, size_t len);
+
+        std::span<uint8_t> buf_;
+        size_t len_ = 0;
+        bool is_valid_ = true;
+    };
+};
+
+/**
+ * @brief Runs a binary command frame through a parser. Arguments are converted to the text the callback would have
+ * received in a text command.
+ * @param[in] parser CppAT parser to run the command with.
+ * @param[in] frame A single complete frame.
+ * @retval True if the frame was well formed and the callback succeeded, false otherwise.
+ */
+template <typename Parser>
+bool CppATParseBinaryMessage(Parser &parser, std::string_view frame)
+{
+    constexpr uint16_t kMaxNumArgs = Parser::kMaxNumArgs;
+    constexpr uint16_t kArgMaxLen = Parser::kArgMaxLen;
+    constexpr char kArgDelimiter = Parser::kArgDelimiter;
+
+    CppATBinary::Header_t header;
+    std::string_view encoded_args;
+    if (!CppATBinary::ReadHeader(frame, header, encoded_args))
+    {
+        CppAT::Printf("CppATParseBinaryMessage: Malformed frame.\r\n");
+        return false;
+    }
+    CppATTraceBuffer *trace_buffer = parser.GetTraceBuffer();
+    const typename Parser::ATCommandDef_t *def = parser.GetATCommand(header.command_index);
+    if (def == nullptr)
+    {
+        CppAT::Printf("CppATParseBinaryMessage: Unable to match command index %d.\r\n", header.command_index);
+        if (trace_buffer != nullptr)
+        {
+            trace_buffer->Record(CppATTraceBuffer::kCommandIndexNone, header.op, header.num_args, {},
+                                 CppATTraceBuffer::Result::kUnknownCommand, trace_buffer->Now(), 0);
+        }
+        return false;
+    }
+    char op = header.op;
+    uint16_t num_args = header.num_args;
+    auto bad_args = [&]()
+    {
+        if (trace_buffer != nullptr)
+        {
+            trace_buffer->Record(parser.GetATCommandIndex(def), op, num_args, {}, CppATTraceBuffer::Result::kBadArgs,
+                                 trace_buffer->Now(), 0);
+        }
+        return false;
+    };
+    if (num_args > kMaxNumArgs || (!def->raw_callback && (num_args < def->min_args || num_args > def->max_args)))
+    {
+        CppAT::Printf("CppATParseBinaryMessage: Received incorrect number of args for command %.*s: got %d, expected "
+                      "minimum %d, maximum %d.\r\n",
+                      static_cast<int>(def->command.length()), def->command.data(), num_args, def->min_args,
+                      std::min(def->max_args, kMaxNumArgs));
+        return bad_args();
+    }
+
+    // Convert the arguments to text joined by delimiters, as they would have appeared in a text command.
+    char args_buf[kMaxNumArgs * (kArgMaxLen + 1)];
+    std::string_view args_list[kMaxNumArgs];
+    size_t args_len = 0;
+    for (uint16_t i = 0; i < num_args; i++)
+    {
+        CppATBinary::ArgType type;
+        std::string_view value;
+        size_t arg_len = SIZE_MAX;
+        if (CppATBinary::ReadArg(encoded_args, type, value))
+        {
+            arg_len = CppATBinary::ArgToText(type, value, args_buf + args_len, kArgMaxLen);
+        }
+        // Raw callbacks split the joined text again, so their arguments can't contain delimiters.
+        if (arg_len == SIZE_MAX ||
+            (def->raw_callback && memchr(args_buf + args_len, kArgDelimiter, arg_len) != nullptr))
+        {
+            CppAT::Printf(
+                "CppATParseBinaryMessage: Argument %d is malformed or too long, must be <=%d characters.\r\n", i,
+                kArgMaxLen);
+            return bad_args();
+        }
+        args_list[i] = std::string_view(args_buf + args_len, arg_len);
+        args_len += arg_len;
+        args_buf[args_len++] = kArgDelimiter;
+    }
+    if (!encoded_args.empty())
+    {
+        CppAT::Printf("CppATParseBinaryMessage: Malformed frame.\r\n");
+        return bad_args();
+    }
+    std::string_view args_string(args_buf, args_len > 0 ? args_len - 1 : 0); // Drop the last delimiter.
+
+    char args_str_buf_list[kMaxNumArgs][kArgMaxLen + 1];
+    if (!def->raw_callback && !def->batch_callback)
+    {
+        // Callbacks expect null terminated arguments.
+        for (uint16_t i = 0; i < num_args; i++)
+        {
+            memcpy(args_str_buf_list[i], args_list[i].data(), args_list[i].length());
+            args_str_buf_list[i][args_list[i].length()] = '\0';
+            args_list[i] = std::string_view(args_str_buf_list[i], args_list[i].length());
+        }
+    }
+    return parser.CallATCommand(def, op, args_list, num_args, args_string);
+}
+
+/**
+ * @brief Runs a message that may start with binary frames, so binary and text commands can share a port. The frames
+ * at the start of the message are run first, then any text after them goes to ParseMessage.
+ * @param[in] parser CppAT parser to run the commands with.
+ * @param[in] message Received bytes.
+ * @retval True if every frame and the text succeeded, false otherwise.
+ */
+template <typename Parser>
+bool CppATParseMessageWithFrames(Parser &parser, std::string_view message)
+{
+    while (!message.empty() && static_cast<uint8_t>(message[0]) == CppATBinary::kLeadByte)
+    {
+        size_t frame_len = CppATBinary::GetFrameLen(message);
+        if (frame_len == 0 || frame_len > message.length())
+        {
+            CppAT::Printf("CppATParseMessageWithFrames: Truncated binary frame.\r\n");
+            return false;
+        }
+        if (!CppATParseBinaryMessage(parser, message.substr(0, frame_len)))
+        {
+            return false;
+        }
+        message.remove_prefix(frame_len);
+        if (message.empty())
+        {
+            return true;
+        }
+    }
+    return parser.ParseMessage(message);
+}
+
+#endif /* _CPP_AT_BINARY_HH_ */
@@ -0,0 +1,282 @@
+#include "cpp_at_codec.hh"
+
+#include <array>
+#include <cstring> // for memcpy
+
+#if CPP_AT_CODEC_SIMD && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CPP_AT_CODEC_X86 1
+#include <immintrin.h>
+#else
+#define CPP_AT_CODEC_X86 0
+#endif
+
+namespace
+{
+
+constexpr uint8_t kInvalid = 0xFF;
+
+constexpr std::array<uint8_t, 256> MakeHexTable()
+{
+    std::array<uint8_t, 256> table{};
+    table.fill(kInvalid);
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        table['0' + i] = i;
+    }
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        table['a' + i] = 10 + i;
+        table['A' + i] = 10 + i;
+    }
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> MakeBase64Table()
+{
+    std::array<uint8_t, 256> table{};
+    table.fill(kInvalid);
+    for (uint8_t i = 0; i < 26; i++)
+    {
+        table['A' + i] = i;
+        table['a' + i] = 26 + i;
+    }
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        table['0' + i] = 52 + i;
+    }
+    table['+'] = 62;
+    table['/'] = 63;
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> kHexTable = MakeHexTable();
+constexpr std::array<uint8_t, 256> kBase64Table = MakeBase64Table();
+
+bool DecodeHexScalar(const uint8_t *in, size_t len, uint8_t *out)
+{
+    for (size_t i = 0; i < len; i += 2)
+    {
+        uint8_t hi = kHexTable[in[i]];
+        uint8_t lo = kHexTable[in[i + 1]];
+        if ((hi | lo) & 0xF0) // Valid values are 4 bits.
+        {
+            return false;
+        }
+        *out++ = static_cast<uint8_t>(hi << 4 | lo);
+    }
+    return true;
+}
+
+/**
+ * @brief Decodes complete groups of 4 characters without padding.
+ */
+bool DecodeBase64Scalar(const uint8_t *in, size_t len, uint8_t *out)
+{
+    for (size_t i = 0; i < len; i += 4)
+    {
+        uint8_t a = kBase64Table[in[i]];
+        uint8_t b = kBase64Table[in[i + 1]];
+        uint8_t c = kBase64Table[in[i + 2]];
+        uint8_t d = kBase64Table[in[i + 3]];
+        if ((a | b | c | d) & 0xC0) // Valid values are 6 bits.
+        {
+            return false;
+        }
+        uint32_t bits = static_cast<uint32_t>(a) << 18 | b << 12 | c << 6 | d;
+        *out++ = static_cast<uint8_t>(bits >> 16);
+        *out++ = static_cast<uint8_t>(bits >> 8);
+        *out++ = static_cast<uint8_t>(bits);
+    }
+    return true;
+}
+
+#if CPP_AT_CODEC_X86
+
+/**
+ * The SIMD functions below decode as many whole blocks as they can and return the number of characters consumed. They
+ * stop at the first block containing an invalid character and leave it to the scalar code, which rejects it.
+ */
+
+// Turns 16 hex characters into nibbles, or returns false if any of them isn't a hex digit.
+__attribute__((target("sse2"))) inline bool HexNibblesSse2(__m128i chars, __m128i &nibbles)
+{
+    __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                     _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+    __m128i is_letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                      _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xFFFF)
+    {
+        return false;
+    }
+    nibbles = _mm_or_si128(_mm_and_si128(is_digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+                           _mm_andnot_si128(is_digit, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+    return true;
+}
+
+__attribute__((target("sse2"))) size_t DecodeHexSse2(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i nibbles;
+        if (!HexNibblesSse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)), nibbles))
+        {
+            break;
+        }
+        // Each 16 bit lane holds the high nibble in its low byte and the low nibble in its high byte.
+        __m128i bytes = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0x00F0)),
+                                     _mm_srli_epi16(nibbles, 8));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i / 2), _mm_packus_epi16(bytes, bytes));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) size_t DecodeHexAvx2(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        __m256i is_digit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)),
+                                            _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+        __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+        __m256i is_letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                             _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+        if (static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter))) != 0xFFFFFFFF)
+        {
+            break;
+        }
+        __m256i nibbles = _mm256_blendv_epi8(_mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10)),
+                                             _mm256_sub_epi8(chars, _mm256_set1_epi8('0')), is_digit);
+        __m256i bytes = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi16(nibbles, 4), _mm256_set1_epi16(0x00F0)),
+                                        _mm256_srli_epi16(nibbles, 8));
+        // Packing works within 128 bit lanes, gather the low 8 bytes of both lanes.
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(bytes, bytes), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i / 2), _mm256_castsi256_si128(packed));
+    }
+    return i;
+}
+
+/**
+ * Decodes 16 characters into 12 bytes per iteration, classifying characters by their nibbles with pshufb (see
+ * W. Muła and D. Lemire, "Faster Base64 Encoding and Decoding Using AVX2 Instructions"). Each iteration stores 16
+ * bytes, so it stops 4 bytes before out_end.
+ */
+__attribute__((target("ssse3"))) size_t DecodeBase64Ssse3(const uint8_t *in, size_t len, uint8_t *out,
+                                                         const uint8_t *out_end)
+{
+    const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B,
+                                         0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                         0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    size_t i = 0;
+    for (; i + 16 <= len && out + 16 <= out_end; i += 16, out += 12)
+    {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(chars, 4), _mm_set1_epi8(0x0F));
+        __m128i lo_nibbles = _mm_and_si128(chars, _mm_set1_epi8(0x0F));
+        __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lut_lo, lo_nibbles), _mm_shuffle_epi8(lut_hi, hi_nibbles));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xFFFF)
+        {
+            break;
+        }
+        // '/' shares its high nibble with '+' but needs a different offset.
+        __m128i is_slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+        __m128i values = _mm_add_epi8(chars, _mm_shuffle_epi8(lut_roll, _mm_add_epi8(is_slash, hi_nibbles)));
+        // Merge pairs of 6 bit values into 12 bits, then pairs of those into 24 bits, and drop the zero bytes.
+        __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        merged = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), merged);
+    }
+    return i;
+}
+
+#endif
+
+} // namespace
+
+/**
+ * CppATCodec Public Functions
+ */
+
+bool CppATCodec::DecodeHex(std::string_view hex, std::span<uint8_t> bytes, size_t &num_bytes)
+{
+    if (hex.length() % 2 != 0 || hex.length() / 2 > bytes.size())
+    {
+        return false;
+    }
+    const uint8_t *in = reinterpret_cast<const uint8_t *>(hex.data());
+    uint8_t *out = bytes.data();
+    size_t num_done = 0;
+#if CPP_AT_CODEC_X86
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    static const bool has_sse2 = __builtin_cpu_supports("sse2");
+    if (has_avx2)
+    {
+        num_done = DecodeHexAvx2(in, hex.length(), out);
+    }
+    if (has_sse2)
+    {
+        num_done += DecodeHexSse2(in + num_done, hex.length() - num_done, out + num_done / 2);
+    }
+#endif
+    if (!DecodeHexScalar(in + num_done, hex.length() - num_done, out + num_done / 2))
+    {
+        return false;
+    }
+    num_bytes = hex.length() / 2;
+    return true;
+}
+
+bool CppATCodec::DecodeBase64(std::string_view base64, std::span<uint8_t> bytes, size_t &num_bytes)
+{
+    if (base64.empty())
+    {
+        num_bytes = 0;
+        return true;
+    }
+    size_t decoded_len = GetBase64DecodedLen(base64);
+    if (decoded_len == 0 || decoded_len > bytes.size())
+    {
+        return false;
+    }
+    const uint8_t *in = reinterpret_cast<const uint8_t *>(base64.data());
+    uint8_t *out = bytes.data();
+    size_t body_len = base64.length() - 4; // The last group may be padded, decode it separately.
+    size_t num_done = 0;
+#if CPP_AT_CODEC_X86
+    static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+    if (has_ssse3)
+    {
+        // Bound the 16 byte stores by the decoded length, not the buffer, so bytes past num_bytes are left alone.
+        num_done = DecodeBase64Ssse3(in, body_len, out, out + decoded_len);
+    }
+#endif
+    if (!DecodeBase64Scalar(in + num_done, body_len - num_done, out + num_done / 4 * 3))
+    {
+        return false;
+    }
+
+    const uint8_t *last = in + body_len;
+    out += body_len / 4 * 3;
+    size_t num_padding = base64.length() * 3 / 4 - decoded_len;
+    // Decode the last group with zeros ('A') in place of the padding.
+    uint8_t group[4] = {last[0], last[1], num_padding < 2 ? last[2] : uint8_t('A'),
+                        num_padding < 1 ? last[3] : uint8_t('A')};
+    uint8_t decoded[3];
+    if (!DecodeBase64Scalar(group, 4, decoded))
+    {
+        return false;
+    }
+    // Padding must not hide set bits, so that each byte string has a single encoding.
+    if ((num_padding == 1 && decoded[2] != 0) || (num_padding == 2 && decoded[1] != 0))
+    {
+        return false;
+    }
+    memcpy(out, decoded, 3 - num_padding);
+    num_bytes = decoded_len;
+    return true;
+}
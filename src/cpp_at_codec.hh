@@ -0,0 +1,59 @@
+#ifndef _CPP_AT_CODEC_HH_
+#define _CPP_AT_CODEC_HH_
+
+#include <span>
+#include <string_view>
+#include "cpp_at_settings.hh"
+#include "stdint.h"
+
+/**
+ * @brief Strict decoders for binary data sent as text arguments, e.g. register blobs or keys. On x86 the bulk of the
+ * input is decoded 16 or 32 characters at a time with SSE2/SSSE3/AVX2, picked at runtime from what the CPU supports,
+ * and the remainder (or everything, on other targets) is decoded with a lookup table. Both paths accept exactly the
+ * same inputs.
+ */
+class CppATCodec
+{
+public:
+    /**
+     * @brief Returns the number of bytes encoded by a hex string, or 0 if its length is odd.
+     */
+    static constexpr size_t GetHexDecodedLen(std::string_view hex)
+    {
+        return hex.length() % 2 == 0 ? hex.length() / 2 : 0;
+    }
+
+    /**
+     * @brief Returns the number of bytes encoded by a padded base64 string, or 0 if its length isn't a multiple of 4.
+     */
+    static constexpr size_t GetBase64DecodedLen(std::string_view base64)
+    {
+        if (base64.length() % 4 != 0 || base64.empty())
+        {
+            return 0;
+        }
+        size_t num_padding = base64.back() == '=' ? (base64[base64.length() - 2] == '=' ? 2 : 1) : 0;
+        return base64.length() / 4 * 3 - num_padding;
+    }
+
+    /**
+     * @brief Decodes a hex string (e.g. "DEADbeef"), upper or lower case, without prefix or separators.
+     * @param[in] hex Text to decode. Must have an even number of characters.
+     * @param[out] bytes Destination for the decoded bytes. Not modified past num_bytes.
+     * @param[out] num_bytes Number of bytes decoded, only valid if decoding succeeded.
+     * @retval True if hex was valid and fit in bytes, false otherwise.
+     */
+    static bool DecodeHex(std::string_view hex, std::span<uint8_t> bytes, size_t &num_bytes);
+
+    /**
+     * @brief Decodes standard base64 (RFC 4648 alphabet with '+' and '/'). Padding is required, and bits left over by
+     * the padding must be zero, so every byte string has exactly one accepted encoding.
+     * @param[in] base64 Text to decode. Length must be a multiple of 4.
+     * @param[out] bytes Destination for the decoded bytes. Not modified past num_bytes.
+     * @param[out] num_bytes Number of bytes decoded, only valid if decoding succeeded.
+     * @retval True if base64 was valid and fit in bytes, false otherwise.
+     */
+    static bool DecodeBase64(std::string_view base64, std::span<uint8_t> bytes, size_t &num_bytes);
+};
+
+#endif /* _CPP_AT_CODEC_HH_ */
@@ -0,0 +1,368 @@
+#include "cpp_at_dispatcher.hh"
+
+#include <algorithm> // for std::max
+
+/**
+ * Lines of a session that have been submitted but not delivered yet, oldest first.
+ */
+class CppATDispatcher::Session
+{
+public:
+    std::mutex mutex;
+    CompletionHandler completion_handler;
+    uint64_t next_sequence = 0;
+    std::deque<Job_t *> pending;
+    uint32_t num_late = 0;    // Timed out jobs that were delivered but are still running.
+    uint32_t num_timeouts = 0; // Timed out jobs the watchdog hasn't delivered yet, it touches the session until then.
+    std::condition_variable drained_cv;
+};
+
+/**
+ * CppATDispatcher Public Functions
+ */
+
+CppATDispatcher::CppATDispatcher(LineHandler handler, uint16_t num_workers, Router router)
+    : handler_(std::move(handler)), router_(std::move(router))
+{
+    if (num_workers == 0)
+    {
+        num_workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (uint16_t i = 0; i < num_workers; i++)
+    {
+        workers_.push_back(std::make_unique<Worker_t>());
+    }
+    // Start threads only once all workers exist, since they steal from each other.
+    for (uint16_t i = 0; i < num_workers; i++)
+    {
+        workers_[i]->thread = std::thread(&CppATDispatcher::WorkerLoop, this, i);
+    }
+    watchdog_thread_ = std::thread(&CppATDispatcher::WatchdogLoop, this);
+}
+
+CppATDispatcher::~CppATDispatcher()
+{
+    Drain();
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        stopping_ = true;
+    }
+    idle_cv_.notify_all();
+    for (std::unique_ptr<Worker_t> &worker : workers_)
+    {
+        worker->thread.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(watchdog_mutex_);
+        watchdog_stopping_ = true;
+    }
+    watchdog_cv_.notify_all();
+    watchdog_thread_.join();
+}
+
+CppATDispatcher::Session *CppATDispatcher::AddSession(CompletionHandler completion_handler)
+{
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    sessions_.push_back(std::make_unique<Session>());
+    sessions_.back()->completion_handler = std::move(completion_handler);
+    return sessions_.back().get();
+}
+
+void CppATDispatcher::RemoveSession(Session *session)
+{
+    {
+        std::unique_lock<std::mutex> session_lock(session->mutex);
+        // Also wait for timed out jobs that are still running, they touch the session when they return.
+        session->drained_cv.wait(session_lock,
+                                 [session]()
+                                 {
+                                     return session->pending.empty() && session->num_late == 0 &&
+                                            session->num_timeouts == 0;
+                                 });
+    }
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    std::erase_if(sessions_, [session](const std::unique_ptr<Session> &s) { return s.get() == session; });
+}
+
+uint64_t CppATDispatcher::Submit(Session *session, std::string_view line)
+{
+    Job_t *job = AllocateJob();
+    job->session = session;
+    job->line.assign(line);
+    job->result = false;
+    job->is_done = false;
+    job->is_timed_out = false;
+    job->is_delivered = false;
+    job->output.Clear();
+    Route_t route = router_ ? router_(line) : Route_t();
+    job->deadline_us = route.deadline_us;
+    {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        job->sequence = session->next_sequence++;
+        session->pending.push_back(job);
+    }
+    num_in_flight_.fetch_add(1, std::memory_order_relaxed);
+
+    if (route.executor != kAnyWorker)
+    {
+        Worker_t &worker = *workers_[route.executor % workers_.size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.pinned.push_back(job);
+        worker.num_pinned.fetch_add(1, std::memory_order_release);
+    }
+    else
+    {
+        // Spread jobs over the workers; idle workers steal whatever ends up behind a long job.
+        Worker_t &worker = *workers_[next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.push_back(job);
+        num_stealable_.fetch_add(1, std::memory_order_release);
+    }
+    {
+        // Taking the lock orders this wakeup after the worker checked for work, so it can't be lost.
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+    }
+    if (route.executor != kAnyWorker)
+    {
+        idle_cv_.notify_all(); // Only the pinned worker can run it, make sure it wakes up.
+    }
+    else
+    {
+        idle_cv_.notify_one();
+    }
+    return job->sequence;
+}
+
+void CppATDispatcher::Drain()
+{
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    drained_cv_.wait(lock, [this]() { return num_in_flight_.load(std::memory_order_acquire) == 0; });
+}
+
+/**
+ * CppATDispatcher Private Functions
+ */
+
+void CppATDispatcher::WorkerLoop(uint16_t index)
+{
+    worker_index_ = index;
+    Worker_t &worker = *workers_[index];
+    while (true)
+    {
+        Job_t *job = PopJob(index);
+        if (job == nullptr)
+        {
+            std::unique_lock<std::mutex> lock(idle_mutex_);
+            idle_cv_.wait(lock,
+                          [this, &worker]()
+                          {
+                              return stopping_ || num_stealable_.load(std::memory_order_acquire) > 0 ||
+                                     worker.num_pinned.load(std::memory_order_acquire) > 0;
+                          });
+            if (stopping_ && num_stealable_ == 0 && worker.num_pinned == 0)
+            {
+                return;
+            }
+            continue;
+        }
+
+        job->worker_index = index;
+        if (job->deadline_us > 0)
+        {
+            std::lock_guard<std::mutex> lock(watchdog_mutex_);
+            worker.running = job;
+            worker.deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(job->deadline_us);
+            watchdog_cv_.notify_one();
+        }
+        {
+            CppATOutputBuffer::Scope output_scope(job->output);
+            job->result = handler_(job->line);
+        }
+        if (job->deadline_us > 0)
+        {
+            std::lock_guard<std::mutex> lock(watchdog_mutex_);
+            worker.running = nullptr;
+        }
+        Complete(job);
+    }
+}
+
+CppATDispatcher::Job_t *CppATDispatcher::PopJob(uint16_t index)
+{
+    Worker_t &worker = *workers_[index];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.pinned.empty())
+        {
+            Job_t *job = worker.pinned.front();
+            worker.pinned.pop_front();
+            worker.num_pinned.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+        if (!worker.jobs.empty())
+        {
+            Job_t *job = worker.jobs.front();
+            worker.jobs.pop_front();
+            num_stealable_.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    // Own queue is empty, steal the newest job of another worker.
+    for (uint16_t offset = 1; offset < workers_.size(); offset++)
+    {
+        Worker_t &victim = *workers_[(index + offset) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            Job_t *job = victim.jobs.back();
+            victim.jobs.pop_back();
+            num_stealable_.fetch_sub(1, std::memory_order_relaxed);
+            num_stolen_.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void CppATDispatcher::Complete(Job_t *job)
+{
+    Session *session = job->session;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    job->is_done = true;
+    if (job->is_delivered)
+    {
+        FreeJob(job); // Timed out and already answered, drop the late result.
+        if (--session->num_late == 0 && session->pending.empty())
+        {
+            session->drained_cv.notify_all();
+        }
+        return;
+    }
+    DeliverReady(session);
+}
+
+void CppATDispatcher::DeliverReady(Session *session)
+{
+    // Deliver every finished or timed out job at the front, so results leave in submission order.
+    size_t num_delivered = 0;
+    while (!session->pending.empty() && (session->pending.front()->is_done || session->pending.front()->is_timed_out))
+    {
+        Job_t *front = session->pending.front();
+        session->pending.pop_front();
+        if (session->completion_handler)
+        {
+            if (front->is_timed_out)
+            {
+                session->completion_handler({.sequence = front->sequence,
+                                             .result = false,
+                                             .output = kTimeoutResponse,
+                                             .num_dropped = 0,
+                                             .worker_index = front->worker_index,
+                                             .timed_out = true});
+            }
+            else
+            {
+                session->completion_handler({.sequence = front->sequence,
+                                             .result = front->result,
+                                             .output = front->output.GetContents(),
+                                             .num_dropped = front->output.GetNumDropped(),
+                                             .worker_index = front->worker_index,
+                                             .timed_out = false});
+            }
+        }
+        front->is_delivered = true;
+        if (front->is_done)
+        {
+            FreeJob(front);
+        }
+        else
+        {
+            session->num_late++; // Freed by its worker in Complete().
+        }
+        num_delivered++;
+    }
+    if (session->pending.empty())
+    {
+        session->drained_cv.notify_all();
+    }
+    if (num_delivered > 0 && num_in_flight_.fetch_sub(num_delivered, std::memory_order_acq_rel) == num_delivered)
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        drained_cv_.notify_all();
+    }
+}
+
+void CppATDispatcher::WatchdogLoop()
+{
+    std::vector<Session *> timed_out_sessions;
+    std::unique_lock<std::mutex> lock(watchdog_mutex_);
+    while (!watchdog_stopping_)
+    {
+        auto now = std::chrono::steady_clock::now();
+        auto next_deadline = std::chrono::steady_clock::time_point::max();
+        for (std::unique_ptr<Worker_t> &worker : workers_)
+        {
+            Job_t *job = worker->running;
+            if (job == nullptr)
+            {
+                continue;
+            }
+            if (worker->deadline > now)
+            {
+                next_deadline = std::min(next_deadline, worker->deadline);
+                continue;
+            }
+            // Deadline passed: answer the host now instead of stalling the session behind this job. Only mark it here,
+            // the completion handler runs below so that it can't hold up workers starting jobs with a deadline.
+            worker->running = nullptr;
+            num_timeouts_.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> session_lock(job->session->mutex);
+            job->is_timed_out = true;
+            job->session->num_timeouts++;
+            timed_out_sessions.push_back(job->session);
+        }
+        if (!timed_out_sessions.empty())
+        {
+            lock.unlock();
+            for (Session *session : timed_out_sessions)
+            {
+                std::lock_guard<std::mutex> session_lock(session->mutex);
+                DeliverReady(session);
+                if (--session->num_timeouts == 0 && session->pending.empty() && session->num_late == 0)
+                {
+                    session->drained_cv.notify_all();
+                }
+            }
+            timed_out_sessions.clear();
+            lock.lock();
+            continue; // Deadlines may have passed while delivering.
+        }
+        if (next_deadline == std::chrono::steady_clock::time_point::max())
+        {
+            watchdog_cv_.wait(lock);
+        }
+        else
+        {
+            watchdog_cv_.wait_until(lock, next_deadline);
+        }
+    }
+}
+
+CppATDispatcher::Job_t *CppATDispatcher::AllocateJob()
+{
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    if (free_jobs_.empty())
+    {
+        jobs_.push_back(std::make_unique<Job_t>());
+        return jobs_.back().get();
+    }
+    Job_t *job = free_jobs_.back();
+    free_jobs_.pop_back();
+    return job;
+}
+
+void CppATDispatcher::FreeJob(Job_t *job)
+{
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    free_jobs_.push_back(job);
+}
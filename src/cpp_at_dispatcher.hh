@@ -0,0 +1,214 @@
+#ifndef _CPP_AT_DISPATCHER_HH_
+#define _CPP_AT_DISPATCHER_HH_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "cpp_at_output.hh"
+#include "cpp_at_settings.hh"
+#include "stdint.h"
+
+/**
+ * @brief Runs AT command lines on a pool of worker threads. Each worker has its own queue and idle workers steal from
+ * the others, while commands pinned to a worker (e.g. ones that own a peripheral) only ever run there. Output printed
+ * by a command is captured and delivered, together with its result, to the session that submitted it in submission
+ * order, no matter which worker finishes first.
+ *
+ * The LineHandler is called from several threads at once. ParseMessage is safe to call concurrently on one parser as
+ * long as the callbacks themselves are thread safe.
+ */
+class CppATDispatcher
+{
+public:
+    static constexpr uint16_t kAnyWorker = UINT16_MAX; // Executor value for commands that can run on any worker.
+    static constexpr uint16_t kOutputBufferLen = CPP_AT_DISPATCHER_OUTPUT_LEN;
+    static constexpr char kTimeoutResponse[] = "ERROR TIMEOUT\r\n"; // Output delivered for lines that time out.
+
+    /**
+     * Function that executes a single line, usually a lambda that calls ParseMessage.
+     */
+    using LineHandler = std::function<bool(std::string_view line)>;
+    struct Route_t
+    {
+        uint16_t executor = kAnyWorker; // Worker that must run the line, or kAnyWorker.
+        uint32_t deadline_us = 0;       // Time the line may run before it times out, or 0 for no deadline.
+    };
+    /**
+     * Function that decides where a line runs and how long it may take. See CppATDispatcherRouter().
+     */
+    using Router = std::function<Route_t(std::string_view line)>;
+
+    struct Completion_t
+    {
+        uint64_t sequence;       // Position of the line among the lines submitted to its session, starting at 0.
+        bool result;             // Value returned by the LineHandler.
+        std::string_view output; // Everything the line printed through CppAT::Printf or CppAT::Format.
+        size_t num_dropped;      // Number of output characters that didn't fit in kOutputBufferLen.
+        uint16_t worker_index;   // Worker that ran the line.
+        bool timed_out;          // Line ran past its deadline. Output is kTimeoutResponse and result is false.
+    };
+    /**
+     * Function called once per submitted line, in submission order for each session. Called from worker threads, but
+     * never concurrently for the same session. Must not submit lines to its own session.
+     */
+    using CompletionHandler = std::function<void(const Completion_t &completion)>;
+
+    class Session; // Opaque handle returned by AddSession().
+
+    /**
+     * @brief Constructor. Starts the worker threads.
+     * @param[in] handler Function that executes lines.
+     * @param[in] num_workers Number of worker threads. 0 uses the number of hardware threads.
+     * @param[in] router Optional function that pins lines to workers.
+     */
+    CppATDispatcher(LineHandler handler, uint16_t num_workers = 0, Router router = nullptr);
+
+    /**
+     * @brief Destructor. Finishes all submitted lines and stops the worker threads.
+     */
+    ~CppATDispatcher();
+
+    CppATDispatcher(const CppATDispatcher &) = delete;
+    CppATDispatcher &operator=(const CppATDispatcher &) = delete;
+
+    /**
+     * @brief Adds a session, e.g. one per serial port or connection.
+     * @param[in] completion_handler Function that receives the results of the session's lines.
+     * @retval Handle to pass to Submit(). Valid until RemoveSession() or the dispatcher is destroyed.
+     */
+    Session *AddSession(CompletionHandler completion_handler);
+
+    /**
+     * @brief Waits for a session's lines to complete and removes it.
+     * @param[in] session Session returned by AddSession().
+     */
+    void RemoveSession(Session *session);
+
+    /**
+     * @brief Queues a line for execution. The line is copied. Lines of the same session must be submitted from one
+     * thread at a time.
+     * @param[in] session Session returned by AddSession().
+     * @param[in] line Line to execute.
+     * @retval Sequence number of the line within its session.
+     */
+    uint64_t Submit(Session *session, std::string_view line);
+
+    /**
+     * @brief Blocks until every submitted line has completed.
+     */
+    void Drain();
+
+    uint16_t GetNumWorkers() const { return workers_.size(); }
+
+    /**
+     * @brief Returns the index of the worker running on the calling thread, or kAnyWorker if it isn't a worker.
+     */
+    static uint16_t GetWorkerIndex() { return worker_index_; }
+
+    /**
+     * @brief Returns the number of lines that were run by a worker other than the one they were queued on.
+     */
+    uint64_t GetNumStolen() const { return num_stolen_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the number of lines that ran past their deadline.
+     */
+    uint64_t GetNumTimeouts() const { return num_timeouts_.load(std::memory_order_relaxed); }
+
+private:
+    struct Job_t
+    {
+        Session *session = nullptr;
+        uint64_t sequence = 0;
+        std::string line;
+        bool result = false;
+        bool is_done = false;      // Handler returned. Guarded by the session mutex, like the flags below.
+        bool is_timed_out = false; // Deadline passed before the handler returned.
+        bool is_delivered = false; // Completion was passed to the session.
+        uint32_t deadline_us = 0;
+        uint16_t worker_index = kAnyWorker;
+        char output_buf[kOutputBufferLen + 1]; // Leave room for '\0' written by vsnprintf.
+        CppATOutputBuffer output = CppATOutputBuffer(output_buf, sizeof(output_buf));
+    };
+
+    struct Worker_t
+    {
+        std::mutex mutex;
+        std::deque<Job_t *> jobs;   // Jobs any worker may run. Owner pops the front, thieves take the back.
+        std::deque<Job_t *> pinned; // Jobs that must run on this worker.
+        std::atomic<uint32_t> num_pinned = 0;
+        std::thread thread;
+        Job_t *running = nullptr; // Job with a deadline that is running, guarded by watchdog_mutex_.
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    void WorkerLoop(uint16_t index);
+    Job_t *PopJob(uint16_t index);
+    void Complete(Job_t *job);
+    void DeliverReady(Session *session);
+    void WatchdogLoop();
+    Job_t *AllocateJob();
+    void FreeJob(Job_t *job);
+
+    static inline thread_local uint16_t worker_index_ = kAnyWorker;
+
+    LineHandler handler_;
+    Router router_;
+    std::vector<std::unique_ptr<Worker_t>> workers_;
+    std::atomic<uint16_t> next_worker_ = 0;
+
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    std::condition_variable drained_cv_;
+    std::atomic<uint64_t> num_stealable_ = 0;
+    std::atomic<uint64_t> num_in_flight_ = 0;
+    std::atomic<uint64_t> num_stolen_ = 0;
+    bool stopping_ = false; // Guarded by idle_mutex_.
+
+    std::mutex watchdog_mutex_;
+    std::condition_variable watchdog_cv_;
+    std::thread watchdog_thread_;
+    bool watchdog_stopping_ = false; // Guarded by watchdog_mutex_.
+    std::atomic<uint64_t> num_timeouts_ = 0;
+
+    std::mutex pool_mutex_;
+    std::vector<std::unique_ptr<Job_t>> jobs_;
+    std::vector<Job_t *> free_jobs_;
+    std::vector<std::unique_ptr<Session>> sessions_;
+};
+
+/**
+ * @brief Creates a Router that sends each line to the executor set in the ATCommandDef_t of its first command, with
+ * the latency_budget_us of the command as its deadline.
+ * @param[in] parser Parser used to look up commands. Must outlive the dispatcher.
+ */
+template <typename Parser>
+CppATDispatcher::Router CppATDispatcherRouter(Parser &parser)
+{
+    return [&parser](std::string_view line) -> CppATDispatcher::Route_t
+    {
+        size_t start = line.find(Parser::kATPrefix);
+        if (start == std::string_view::npos)
+        {
+            return {};
+        }
+        start += Parser::kATPrefixLen;
+        size_t end = line.find_first_of(Parser::kATAllowedOpChars, start);
+        auto def = parser.LookupATCommand(line.substr(start, end == std::string_view::npos ? end : end - start));
+        if (def == nullptr)
+        {
+            return {};
+        }
+        return {.executor = def->executor, .deadline_us = def->latency_budget_us};
+    };
+}
+
+#endif /* _CPP_AT_DISPATCHER_HH_ */
@@ -0,0 +1,412 @@
+#include "cpp_at_epoll_server.hh"
+
+#if defined(__linux__)
+
+#include <algorithm> // for std::min
+#include <cerrno>
+#include <fcntl.h>       // for fcntl
+#include <sys/epoll.h>   // for epoll_create1, epoll_ctl, epoll_wait
+#include <sys/eventfd.h> // for eventfd
+#include <sys/socket.h>  // for accept4
+#include <unistd.h>      // for read, write, close
+#include "cpp_at.hh"
+#include "cpp_at_binary.hh"
+
+namespace
+{
+
+constexpr uint32_t kStopEventIndex = UINT32_MAX; // epoll_event.data.u32 used for the stop eventfd.
+constexpr int kMaxEventsPerPoll = 64;
+
+bool SetNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+} // namespace
+
+/**
+ * Public Functions
+ */
+
+CppATEpollServer::CppATEpollServer(uint16_t max_sessions) : sessions_(max_sessions)
+{
+    // Chain all sessions into the free list.
+    for (int32_t i = max_sessions - 1; i >= 0; i--)
+    {
+        sessions_[i].next_free = first_free_;
+        first_free_ = i;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || stop_fd_ < 0)
+    {
+        CppAT::Printf("CppATEpollServer: Unable to create epoll instance.\r\n");
+        return;
+    }
+    epoll_event event = {.events = EPOLLIN, .data = {.u32 = kStopEventIndex}};
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, stop_fd_, &event) != 0)
+    {
+        CppAT::Printf("CppATEpollServer: Unable to register stop event.\r\n");
+        return;
+    }
+    is_valid = true;
+}
+
+CppATEpollServer::~CppATEpollServer()
+{
+    for (Session_t &session : sessions_)
+    {
+        if (session.fd >= 0)
+        {
+            close(session.fd);
+        }
+    }
+    if (stop_fd_ >= 0)
+    {
+        close(stop_fd_);
+    }
+    if (epoll_fd_ >= 0)
+    {
+        close(epoll_fd_);
+    }
+}
+
+bool CppATEpollServer::AddFd(int fd, LineHandler handler)
+{
+    Session_t *session = AllocateSession(fd);
+    if (session == nullptr)
+    {
+        return false;
+    }
+    session->handler = std::move(handler);
+    return true;
+}
+
+bool CppATEpollServer::AddListener(int listen_fd, AcceptHandler accept_handler)
+{
+    Session_t *session = AllocateSession(listen_fd);
+    if (session == nullptr)
+    {
+        return false;
+    }
+    session->is_listener = true;
+    session->accept_handler = std::move(accept_handler);
+    return true;
+}
+
+bool CppATEpollServer::RemoveFd(int fd)
+{
+    for (Session_t &session : sessions_)
+    {
+        if (session.fd == fd && fd >= 0)
+        {
+            CloseSession(session);
+            return true;
+        }
+    }
+    return false;
+}
+
+int CppATEpollServer::Poll(int timeout_ms)
+{
+    epoll_event events[kMaxEventsPerPoll];
+    int num_events = epoll_wait(epoll_fd_, events, kMaxEventsPerPoll, timeout_ms);
+    if (num_events < 0)
+    {
+        return errno == EINTR ? 0 : -1;
+    }
+    for (int i = 0; i < num_events; i++)
+    {
+        uint32_t index = events[i].data.u32;
+        if (index == kStopEventIndex)
+        {
+            uint64_t count;
+            while (read(stop_fd_, &count, sizeof(count)) > 0)
+            {
+            }
+            continue;
+        }
+        Session_t &session = sessions_[index];
+        if (session.fd < 0)
+        {
+            continue; // Session was closed while handling an earlier event.
+        }
+        if (session.is_listener)
+        {
+            HandleAccept(session);
+            continue;
+        }
+        if (events[i].events & EPOLLOUT)
+        {
+            if (!Flush(session))
+            {
+                CloseSession(session);
+                continue;
+            }
+        }
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR | EPOLLRDHUP))
+        {
+            // Read first even on hangup so that the last lines sent before closing are still handled.
+            HandleRead(session);
+        }
+    }
+    return num_events;
+}
+
+void CppATEpollServer::Run()
+{
+    while (!stop_)
+    {
+        if (Poll(-1) < 0)
+        {
+            break;
+        }
+    }
+    stop_ = false;
+}
+
+void CppATEpollServer::Stop()
+{
+    stop_ = true;
+    uint64_t one = 1;
+    (void)!write(stop_fd_, &one, sizeof(one));
+}
+
+/**
+ * Private Functions
+ */
+
+CppATEpollServer::Session_t *CppATEpollServer::AllocateSession(int fd)
+{
+    if (!is_valid || fd < 0)
+    {
+        return nullptr;
+    }
+    if (first_free_ < 0)
+    {
+        CppAT::Printf("CppATEpollServer: Unable to add fd %d, all %d sessions are in use.\r\n", fd,
+                      static_cast<int>(sessions_.size()));
+        return nullptr;
+    }
+    if (!SetNonBlocking(fd))
+    {
+        CppAT::Printf("CppATEpollServer: Unable to make fd %d non-blocking.\r\n", fd);
+        return nullptr;
+    }
+    int32_t index = first_free_;
+    epoll_event event = {.events = EPOLLIN | EPOLLRDHUP, .data = {.u32 = static_cast<uint32_t>(index)}};
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        CppAT::Printf("CppATEpollServer: Unable to register fd %d with epoll.\r\n", fd);
+        return nullptr;
+    }
+    Session_t &session = sessions_[index];
+    first_free_ = session.next_free;
+    session.fd = fd;
+    session.is_listener = false;
+    session.want_write = false;
+    session.discarding = false;
+    session.num_to_skip = 0;
+    session.rx_len = 0;
+    session.tx.Clear();
+    num_sessions_++;
+    return &session;
+}
+
+void CppATEpollServer::CloseSession(Session_t &session)
+{
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, session.fd, nullptr);
+    close(session.fd);
+    session.fd = -1;
+    session.handler = nullptr;
+    session.accept_handler = nullptr;
+    session.next_free = first_free_;
+    first_free_ = &session - sessions_.data();
+    num_sessions_--;
+}
+
+void CppATEpollServer::HandleRead(Session_t &session)
+{
+    while (true)
+    {
+        ssize_t num_read = read(session.fd, session.rx_buf + session.rx_len, kRxBufferLen - session.rx_len);
+        if (num_read > 0)
+        {
+            int fd = session.fd;
+            session.rx_len += num_read;
+            HandleLines(session);
+            if (session.fd != fd)
+            {
+                return; // Session was closed by its handler.
+            }
+            continue;
+        }
+        if (num_read < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (num_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        // End of file, hangup (EIO on a pty whose other side closed) or error. A peer that only shut down its
+        // writing side still expects the responses to what it sent, so send what is queued before closing.
+        Flush(session);
+        CloseSession(session);
+        return;
+    }
+    if (!Flush(session))
+    {
+        CloseSession(session);
+    }
+}
+
+void CppATEpollServer::HandleAccept(Session_t &session)
+{
+    while (true)
+    {
+        int fd = accept4(session.fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            return; // EAGAIN when there are no more pending connections.
+        }
+        if (!AddFd(fd, session.accept_handler(fd)))
+        {
+            close(fd);
+        }
+    }
+}
+
+void CppATEpollServer::HandleLines(Session_t &session)
+{
+    uint16_t line_start = 0;
+    uint16_t i = 0;
+    while (i < session.rx_len)
+    {
+        if (session.num_to_skip > 0)
+        {
+            // Rest of a binary frame that was too long for the receive buffer.
+            uint16_t num_skipped = std::min<size_t>(session.num_to_skip, session.rx_len - i);
+            session.num_to_skip -= num_skipped;
+            num_rx_dropped_ += num_skipped;
+            i += num_skipped;
+            line_start = i;
+            continue;
+        }
+        bool is_frame_start = binary_frames_ && static_cast<uint8_t>(session.rx_buf[i]) == CppATBinary::kLeadByte;
+        if (i == line_start && !session.discarding && is_frame_start)
+        {
+            // Binary frames may contain '\n', so they are cut by their length.
+            size_t frame_len = CppATBinary::GetFrameLen(std::string_view(session.rx_buf + i, session.rx_len - i));
+            if (frame_len > kRxBufferLen)
+            {
+                session.num_to_skip = frame_len;
+                continue;
+            }
+            if (frame_len == 0 || i + frame_len > session.rx_len)
+            {
+                break; // Wait for the rest of the frame.
+            }
+            i += frame_len;
+            line_start = i;
+            if (!RunHandler(session, std::string_view(session.rx_buf + i - frame_len, frame_len)))
+            {
+                return;
+            }
+            continue;
+        }
+        if (session.rx_buf[i++] != '\n')
+        {
+            continue;
+        }
+        std::string_view line(session.rx_buf + line_start, i - line_start);
+        line_start = i;
+        if (session.discarding)
+        {
+            // Tail end of a line that was too long for the receive buffer.
+            session.discarding = false;
+            num_rx_dropped_ += line.length();
+            continue;
+        }
+        if (!RunHandler(session, line))
+        {
+            return;
+        }
+    }
+
+    if (line_start > 0)
+    {
+        // Keep the partial line for the next read.
+        memmove(session.rx_buf, session.rx_buf + line_start, session.rx_len - line_start);
+        session.rx_len -= line_start;
+    }
+    else if (session.rx_len == kRxBufferLen)
+    {
+        // Line doesn't fit in the receive buffer, drop it.
+        num_rx_dropped_ += session.rx_len;
+        session.rx_len = 0;
+        session.discarding = true;
+    }
+}
+
+bool CppATEpollServer::RunHandler(Session_t &session, std::string_view line)
+{
+    int fd = session.fd;
+    size_t num_dropped = session.tx.GetNumDropped();
+    {
+        CppATOutputBuffer::Scope output_scope(session.tx);
+        session.handler(fd, line);
+    }
+    if (session.fd != fd)
+    {
+        return false; // Session was closed by its handler.
+    }
+    num_tx_dropped_ += session.tx.GetNumDropped() - num_dropped;
+    return true;
+}
+
+bool CppATEpollServer::Flush(Session_t &session)
+{
+    while (session.tx.GetLength() > 0)
+    {
+        std::string_view contents = session.tx.GetContents();
+        ssize_t num_written = write(session.fd, contents.data(), contents.length());
+        if (num_written > 0)
+        {
+            session.tx.Consume(num_written);
+            continue;
+        }
+        if (num_written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (num_written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        return false;
+    }
+
+    // Only ask for EPOLLOUT while there is something left to send.
+    bool want_write = session.tx.GetLength() > 0;
+    if (want_write != session.want_write)
+    {
+        epoll_event event = {.events = EPOLLIN | EPOLLRDHUP | (want_write ? EPOLLOUT : 0u),
+                             .data = {.u32 = static_cast<uint32_t>(&session - sessions_.data())}};
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, session.fd, &event) != 0)
+        {
+            return false;
+        }
+        session.want_write = want_write;
+    }
+    return true;
+}
+
+#endif /* __linux__ */
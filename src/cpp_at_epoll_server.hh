@@ -0,0 +1,150 @@
+#ifndef _CPP_AT_EPOLL_SERVER_HH_
+#define _CPP_AT_EPOLL_SERVER_HH_
+
+#include <atomic>
+#include <functional>
+#include <string_view>
+#include <vector>
+#include "cpp_at_output.hh"
+#include "cpp_at_settings.hh"
+#include "stdint.h"
+
+/**
+ * @brief Linux transport that drives CppAT sessions for many file descriptors (ttys, ptys, UNIX or TCP sockets) from a
+ * single epoll loop. Received bytes are split into lines and handed to the session's LineHandler (usually a lambda
+ * calling ParseMessage). With SetBinaryFrames(), binary command frames (see CppATBinary) are cut by their length
+ * instead and handed over whole. Everything the handler prints through CppAT::Printf is collected in the session's
+ * transmit buffer and written back to the same file descriptor without blocking.
+ */
+class CppATEpollServer
+{
+public:
+    static constexpr uint16_t kRxBufferLen = CPP_AT_SERVER_RX_BUFFER_LEN;
+    static constexpr uint16_t kTxBufferLen = CPP_AT_SERVER_TX_BUFFER_LEN;
+
+    /**
+     * Function that executes a single received line, including its line ending.
+     */
+    using LineHandler = std::function<bool(int fd, std::string_view line)>;
+    /**
+     * Function that creates a LineHandler for a connection accepted from a listening socket.
+     */
+    using AcceptHandler = std::function<LineHandler(int fd)>;
+
+    /**
+     * @brief Constructor. All session storage is allocated here, so the loop itself never allocates.
+     * @param[in] max_sessions Maximum number of file descriptors (including listening sockets) that can be served.
+     */
+    explicit CppATEpollServer(uint16_t max_sessions = 256);
+
+    /**
+     * @brief Destructor. Closes all file descriptors that were added to the server.
+     */
+    ~CppATEpollServer();
+
+    CppATEpollServer(const CppATEpollServer &) = delete;
+    CppATEpollServer &operator=(const CppATEpollServer &) = delete;
+
+    /**
+     * @brief Adds a file descriptor to serve. The descriptor is switched to non-blocking mode and the server takes
+     * ownership of it: it is closed when the session ends or the server is destroyed.
+     * @param[in] fd File descriptor of a tty, pty or connected socket.
+     * @param[in] handler Function called for every line received on fd.
+     * @retval True if the descriptor was added, false otherwise.
+     */
+    bool AddFd(int fd, LineHandler handler);
+
+    /**
+     * @brief Adds a listening socket. Accepted connections are added as new sessions.
+     * @param[in] listen_fd Socket that listen() has been called on. The server takes ownership of it.
+     * @param[in] accept_handler Function that returns the LineHandler for each accepted connection.
+     * @retval True if the socket was added, false otherwise.
+     */
+    bool AddListener(int listen_fd, AcceptHandler accept_handler);
+
+    /**
+     * @brief Stops serving a file descriptor and closes it.
+     * @param[in] fd File descriptor to remove.
+     * @retval True if the descriptor was found and removed, false otherwise.
+     */
+    bool RemoveFd(int fd);
+
+    /**
+     * @brief Turns cutting binary command frames (see CppATBinary) by their length on or off for all sessions. Off by
+     * default, so a 0xFE byte is just part of a text line. Handlers should then run what they receive with
+     * CppATParseMessageWithFrames().
+     * @param[in] enable True to cut binary frames, false to treat all received bytes as text lines.
+     */
+    void SetBinaryFrames(bool enable) { binary_frames_ = enable; }
+
+    /**
+     * @brief Waits for events and handles them once.
+     * @param[in] timeout_ms Maximum time to wait in milliseconds, or -1 to wait forever.
+     * @retval Number of events handled, or -1 on error.
+     */
+    int Poll(int timeout_ms);
+
+    /**
+     * @brief Calls Poll() until Stop() is called.
+     */
+    void Run();
+
+    /**
+     * @brief Makes Run() return. Safe to call from any thread or from a LineHandler.
+     */
+    void Stop();
+
+    /**
+     * @brief Returns the number of file descriptors being served, including listening sockets.
+     */
+    uint16_t GetNumSessions() const { return num_sessions_; }
+
+    /**
+     * @brief Returns the number of response bytes that were dropped because a transmit buffer was full.
+     */
+    uint64_t GetNumTxDropped() const { return num_tx_dropped_; }
+
+    /**
+     * @brief Returns the number of received bytes that were dropped because a line didn't fit in the receive buffer.
+     */
+    uint64_t GetNumRxDropped() const { return num_rx_dropped_; }
+
+    bool is_valid = false;
+
+private:
+    struct Session_t
+    {
+        int fd = -1;
+        bool is_listener = false;
+        bool want_write = false; // EPOLLOUT is registered because the transmit buffer couldn't be fully written.
+        bool discarding = false; // Dropping received bytes until the end of an oversized line.
+        size_t num_to_skip = 0;  // Received bytes still to drop from an oversized binary frame.
+        LineHandler handler = nullptr;
+        AcceptHandler accept_handler = nullptr;
+        uint16_t rx_len = 0;
+        char rx_buf[kRxBufferLen];
+        char tx_buf[kTxBufferLen + 1]; // Leave room for '\0' written by vsnprintf.
+        CppATOutputBuffer tx = CppATOutputBuffer(tx_buf, sizeof(tx_buf));
+        int32_t next_free = -1; // Index of the next unused session.
+    };
+
+    Session_t *AllocateSession(int fd);
+    void CloseSession(Session_t &session);
+    void HandleRead(Session_t &session);
+    void HandleAccept(Session_t &session);
+    void HandleLines(Session_t &session);
+    bool RunHandler(Session_t &session, std::string_view line);
+    bool Flush(Session_t &session);
+
+    int epoll_fd_ = -1;
+    int stop_fd_ = -1; // eventfd used to wake up the loop from Stop().
+    std::atomic<bool> stop_ = false;
+    std::vector<Session_t> sessions_;
+    int32_t first_free_ = -1;
+    uint16_t num_sessions_ = 0;
+    uint64_t num_tx_dropped_ = 0;
+    uint64_t num_rx_dropped_ = 0;
+    bool binary_frames_ = false;
+};
+
+#endif /* _CPP_AT_EPOLL_SERVER_HH_ */
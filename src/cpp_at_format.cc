@@ -0,0 +1,241 @@
+#include "cpp_at_format.hh"
+
+#include <charconv> // for std::to_chars
+#include <cstdio>   // for snprintf
+#include <cstdlib>  // for strtof, strtod
+#include <cstring>  // for memcpy
+#include <limits>
+
+namespace
+{
+
+void Write(CppATFormat::Writer_t &writer, const char *data, size_t len)
+{
+    writer.total_len += len;
+    while (len > 0)
+    {
+        size_t available = writer.capacity - writer.len;
+        if (available == 0)
+        {
+            if (writer.flush == nullptr)
+            {
+                return; // Drop the rest.
+            }
+            writer.flush(writer);
+            available = writer.capacity - writer.len;
+        }
+        size_t num_to_copy = len < available ? len : available;
+        memcpy(writer.buf + writer.len, data, num_to_copy);
+        writer.len += num_to_copy;
+        data += num_to_copy;
+        len -= num_to_copy;
+    }
+}
+
+void Pad(CppATFormat::Writer_t &writer, char fill, size_t len)
+{
+    static constexpr char kSpaces[] = "                ";
+    static constexpr char kZeros[] = "0000000000000000";
+    const char *pad = fill == '0' ? kZeros : kSpaces;
+    while (len > 0)
+    {
+        size_t num_to_write = len < sizeof(kSpaces) - 1 ? len : sizeof(kSpaces) - 1;
+        Write(writer, pad, num_to_write);
+        len -= num_to_write;
+    }
+}
+
+} // namespace
+
+/**
+ * CppATFormat Public Functions
+ */
+
+void CppATFormat::Format(Writer_t &writer, std::string_view format, const Arg_t args[])
+{
+    uint16_t arg_index = 0;
+    size_t literal_start = 0;
+    for (size_t i = 0; i < format.length(); i++)
+    {
+        char c = format[i];
+        if (c != '{' && c != '}')
+        {
+            continue;
+        }
+        Write(writer, format.data() + literal_start, i - literal_start);
+        if (c == '}' || format[i + 1] == '{')
+        {
+            // Escaped brace, print one of the two.
+            i++;
+            literal_start = i;
+            continue;
+        }
+        Spec_t spec;
+        i = ParseSpec(format, i + 1, spec);
+        WriteArg(writer, spec, args[arg_index++]);
+        literal_start = i + 1;
+    }
+    Write(writer, format.data() + literal_start, format.length() - literal_start);
+}
+
+/**
+ * CppATFormat Private Functions
+ */
+
+void CppATFormat::WriteArg(Writer_t &writer, const Spec_t &spec, const Arg_t &arg)
+{
+    char buf[64]; // Large enough for any integer in binary, or a float with 17 digits and an exponent.
+    char *end = buf;
+    const char *text = buf;
+    bool is_number = true;
+
+    int base = 10;
+    switch (spec.type)
+    {
+        case 'x':
+        case 'X':
+            base = 16;
+            break;
+        case 'b':
+            base = 2;
+            break;
+        case 'o':
+            base = 8;
+            break;
+        default:
+            break;
+    }
+
+    switch (arg.kind)
+    {
+        case ArgKind::kBool:
+            text = arg.b ? "true" : "false";
+            end = const_cast<char *>(text) + (arg.b ? 4 : 5);
+            is_number = false;
+            break;
+        case ArgKind::kChar:
+            if (spec.type == '\0' || spec.type == 'c')
+            {
+                buf[0] = arg.c;
+                end = buf + 1;
+                is_number = false;
+            }
+            else
+            {
+                end = std::to_chars(buf, buf + sizeof(buf), static_cast<int>(arg.c), base).ptr;
+            }
+            break;
+        case ArgKind::kSigned:
+            end = std::to_chars(buf, buf + sizeof(buf), arg.i, base).ptr;
+            break;
+        case ArgKind::kUnsigned:
+            end = std::to_chars(buf, buf + sizeof(buf), arg.u, base).ptr;
+            break;
+        case ArgKind::kFloat:
+        case ArgKind::kDouble:
+        {
+#if defined(__cpp_lib_to_chars)
+            std::chars_format fmt = spec.type == 'f'   ? std::chars_format::fixed
+                                    : spec.type == 'e' ? std::chars_format::scientific
+                                                       : std::chars_format::general;
+            std::to_chars_result result;
+            if (spec.precision < 0 && spec.type == '\0')
+            {
+                // Shortest representation that round trips, like std::format.
+                result = arg.kind == ArgKind::kFloat ? std::to_chars(buf, buf + sizeof(buf), arg.f)
+                                                     : std::to_chars(buf, buf + sizeof(buf), arg.d);
+            }
+            else
+            {
+                int precision = spec.precision < 0 ? 6 : spec.precision;
+                double value = arg.kind == ArgKind::kFloat ? arg.f : arg.d;
+                result = std::to_chars(buf, buf + sizeof(buf), value, fmt, precision);
+                if (result.ec != std::errc())
+                {
+                    // Too many digits for fixed notation, fall back to scientific.
+                    result = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::scientific,
+                                           precision > 17 ? 17 : precision);
+                }
+            }
+            end = result.ec == std::errc() ? result.ptr : buf;
+#else
+            // No floating point std::to_chars (e.g. GCC 10), use snprintf with the closest printf conversion.
+            double value = arg.kind == ArgKind::kFloat ? arg.f : arg.d;
+            int precision = spec.precision < 0 ? 6 : spec.precision;
+            if (spec.precision < 0 && spec.type == '\0')
+            {
+                // Shortest representation that round trips, like std::format.
+                int max_precision = arg.kind == ArgKind::kFloat ? std::numeric_limits<float>::max_digits10
+                                                                : std::numeric_limits<double>::max_digits10;
+                for (precision = 1; precision < max_precision; precision++)
+                {
+                    snprintf(buf, sizeof(buf), "%.*g", precision, value);
+                    if (arg.kind == ArgKind::kFloat ? strtof(buf, nullptr) == arg.f : strtod(buf, nullptr) == arg.d)
+                    {
+                        break;
+                    }
+                }
+            }
+            const char *conversion = spec.type == 'f' ? "%.*f" : spec.type == 'e' ? "%.*e" : "%.*g";
+            int len = snprintf(buf, sizeof(buf), conversion, precision, value);
+            if (len < 0 || static_cast<size_t>(len) >= sizeof(buf))
+            {
+                // Too many digits for fixed notation, fall back to scientific.
+                len = snprintf(buf, sizeof(buf), "%.*e", precision > 17 ? 17 : precision, value);
+            }
+            end = len < 0 || static_cast<size_t>(len) >= sizeof(buf) ? buf : buf + len;
+#endif
+            break;
+        }
+        case ArgKind::kString:
+            text = arg.s.data;
+            end = const_cast<char *>(text) + arg.s.len;
+            if (spec.precision >= 0 && arg.s.len > static_cast<size_t>(spec.precision))
+            {
+                end = const_cast<char *>(text) + spec.precision;
+            }
+            is_number = false;
+            break;
+        default:
+            break;
+    }
+
+    if (spec.type == 'X')
+    {
+        for (char *p = buf; p < end; p++)
+        {
+            *p = (*p >= 'a' && *p <= 'f') ? *p - 'a' + 'A' : *p;
+        }
+    }
+
+    size_t len = end - text;
+    size_t padding = spec.width > len ? spec.width - len : 0;
+    if (padding == 0)
+    {
+        Write(writer, text, len);
+        return;
+    }
+    if (spec.zero_pad && is_number)
+    {
+        // Zeros go between the sign and the digits.
+        if (*text == '-')
+        {
+            Write(writer, text, 1);
+            text++;
+            len--;
+        }
+        Pad(writer, '0', padding);
+        Write(writer, text, len);
+        return;
+    }
+    bool align_right = spec.align == '>' || (spec.align == '\0' && is_number);
+    if (align_right)
+    {
+        Pad(writer, ' ', padding);
+    }
+    Write(writer, text, len);
+    if (!align_right)
+    {
+        Pad(writer, ' ', padding);
+    }
+}
@@ -0,0 +1,368 @@
+#ifndef _CPP_AT_FORMAT_HH_
+#define _CPP_AT_FORMAT_HH_
+
+#include <string_view>
+#include <type_traits>
+#include "stdint.h"
+
+/**
+ * std::format style formatting for AT responses. Format strings are checked against the argument types at compile
+ * time, and values are converted with std::to_chars straight into the destination buffer, without vsnprintf. Standard
+ * libraries without floating point std::to_chars (GCC 10) format floats with snprintf instead.
+ *
+ * Replacement fields: {[:[align][0][width][.precision][type]]}
+ *  align: '<' (default for strings, chars and bools) or '>' (default for numbers).
+ *  0: pad numbers with zeros after the sign instead of with spaces.
+ *  precision: digits after the decimal point for floats ('f', 'e') or significant digits ('g' and no type).
+ *  type: integers 'd', 'x', 'X', 'b', 'o'; floats 'f', 'e', 'g'; strings and bools 's'; chars 'c' or an integer type.
+ * Use "{{" and "}}" for literal braces.
+ */
+class CppATFormat
+{
+public:
+    enum class ArgKind : uint8_t
+    {
+        kInvalid = 0,
+        kBool,
+        kChar,
+        kSigned,
+        kUnsigned,
+        kFloat,
+        kDouble,
+        kString
+    };
+
+    /**
+     * Type erased argument, so that the formatting loop is compiled once instead of once per argument list.
+     */
+    struct Arg_t
+    {
+        ArgKind kind = ArgKind::kInvalid;
+        union
+        {
+            bool b;
+            char c;
+            int64_t i;
+            uint64_t u;
+            float f;
+            double d;
+            struct
+            {
+                const char *data;
+                size_t len;
+            } s;
+        };
+    };
+
+    /**
+     * Destination of formatted text. Text that doesn't fit in buf is passed to flush (which must empty buf) if it is
+     * set, or dropped otherwise.
+     */
+    struct Writer_t
+    {
+        char *buf;
+        size_t capacity;
+        size_t len = 0;
+        size_t total_len = 0; // Length of the full output, including any dropped text.
+        void (*flush)(Writer_t &writer) = nullptr;
+        void *context = nullptr;
+    };
+
+    /**
+     * @brief Returns the formatting category of an argument type.
+     */
+    template <typename T>
+    static consteval ArgKind GetArgKind()
+    {
+        using U = std::remove_cvref_t<T>;
+        if constexpr (std::is_same_v<U, bool>)
+        {
+            return ArgKind::kBool;
+        }
+        else if constexpr (std::is_same_v<U, char>)
+        {
+            return ArgKind::kChar;
+        }
+        else if constexpr (std::is_enum_v<U>)
+        {
+            return GetArgKind<std::underlying_type_t<U>>();
+        }
+        else if constexpr (std::is_integral_v<U>)
+        {
+            return std::is_signed_v<U> ? ArgKind::kSigned : ArgKind::kUnsigned;
+        }
+        else if constexpr (std::is_same_v<U, float>)
+        {
+            return ArgKind::kFloat;
+        }
+        else if constexpr (std::is_floating_point_v<U>)
+        {
+            return ArgKind::kDouble;
+        }
+        else if constexpr (std::is_convertible_v<const U &, std::string_view> ||
+                           std::is_convertible_v<const U &, const char *>)
+        {
+            return ArgKind::kString;
+        }
+        return ArgKind::kInvalid;
+    }
+
+    template <typename T>
+    static Arg_t MakeArg(const T &value)
+    {
+        Arg_t arg;
+        arg.kind = GetArgKind<T>();
+        if constexpr (std::is_enum_v<T>)
+        {
+            return MakeArg(static_cast<std::underlying_type_t<T>>(value));
+        }
+        else if constexpr (GetArgKind<T>() == ArgKind::kBool)
+        {
+            arg.b = value;
+        }
+        else if constexpr (GetArgKind<T>() == ArgKind::kChar)
+        {
+            arg.c = value;
+        }
+        else if constexpr (GetArgKind<T>() == ArgKind::kSigned)
+        {
+            arg.i = value;
+        }
+        else if constexpr (GetArgKind<T>() == ArgKind::kUnsigned)
+        {
+            arg.u = value;
+        }
+        else if constexpr (GetArgKind<T>() == ArgKind::kFloat)
+        {
+            arg.f = value;
+        }
+        else if constexpr (GetArgKind<T>() == ArgKind::kDouble)
+        {
+            arg.d = static_cast<double>(value);
+        }
+        else if constexpr (std::is_convertible_v<const T &, const char *>)
+        {
+            const char *text = value;
+            std::string_view view = text != nullptr ? std::string_view(text) : std::string_view("(null)");
+            arg.s = {view.data(), view.length()};
+        }
+        else
+        {
+            std::string_view text = value;
+            arg.s = {text.data(), text.length()};
+        }
+        return arg;
+    }
+
+    /**
+     * @brief Checks a format string against a list of argument kinds. Compilation fails at the first problem, with an
+     * error pointing at a call to one of the FormatStringError functions below.
+     */
+    static consteval void Check(std::string_view format, const ArgKind kinds[], size_t num_args)
+    {
+        size_t arg_index = 0;
+        for (size_t i = 0; i < format.length(); i++)
+        {
+            if (format[i] == '}')
+            {
+                if (i + 1 >= format.length() || format[i + 1] != '}')
+                {
+                    FormatStringError_UnmatchedClosingBrace();
+                }
+                i++;
+                continue;
+            }
+            if (format[i] != '{')
+            {
+                continue;
+            }
+            if (i + 1 < format.length() && format[i + 1] == '{')
+            {
+                i++;
+                continue;
+            }
+            if (arg_index >= num_args)
+            {
+                FormatStringError_NotEnoughArguments();
+            }
+            ArgKind kind = kinds[arg_index++];
+            if (kind == ArgKind::kInvalid)
+            {
+                FormatStringError_UnsupportedArgumentType();
+            }
+            Spec_t spec;
+            i = ParseSpec(format, i + 1, spec);
+            if (i == 0)
+            {
+                FormatStringError_InvalidReplacementField();
+            }
+            if (!IsValidSpec(spec, kind))
+            {
+                FormatStringError_SpecDoesNotMatchArgumentType();
+            }
+        }
+        if (arg_index != num_args)
+        {
+            FormatStringError_TooManyArguments();
+        }
+    }
+
+    /**
+     * @brief Formats arguments into a writer. The format string must have been checked with Check().
+     * @param[in] writer Destination of the formatted text.
+     * @param[in] format Format string.
+     * @param[in] args Arguments for the replacement fields, in order.
+     */
+    static void Format(Writer_t &writer, std::string_view format, const Arg_t args[]);
+
+    /**
+     * @brief Formats into a character buffer. Output that doesn't fit is truncated.
+     * @retval Length of the full output, which may be larger than buf_len.
+     */
+    static size_t Format(char *buf, size_t buf_len, std::string_view format, const Arg_t args[])
+    {
+        Writer_t writer = {.buf = buf, .capacity = buf_len};
+        Format(writer, format, args);
+        return writer.total_len;
+    }
+
+private:
+    struct Spec_t
+    {
+        char align = '\0';
+        bool zero_pad = false;
+        uint16_t width = 0;
+        int16_t precision = -1;
+        char type = '\0';
+    };
+
+    /**
+     * @brief Parses a replacement field starting after its '{'.
+     * @retval Index of the closing '}', or 0 if the field is invalid.
+     */
+    static constexpr size_t ParseSpec(std::string_view format, size_t pos, Spec_t &spec)
+    {
+        auto at = [&format](size_t i) { return i < format.length() ? format[i] : '\0'; };
+        if (at(pos) == '}')
+        {
+            return pos;
+        }
+        if (at(pos) != ':')
+        {
+            return 0;
+        }
+        pos++;
+        if (at(pos) == '<' || at(pos) == '>')
+        {
+            spec.align = at(pos++);
+        }
+        if (at(pos) == '0')
+        {
+            spec.zero_pad = true;
+            pos++;
+        }
+        for (; at(pos) >= '0' && at(pos) <= '9'; pos++)
+        {
+            if (spec.width > 999)
+            {
+                return 0;
+            }
+            spec.width = spec.width * 10 + (at(pos) - '0');
+        }
+        if (at(pos) == '.')
+        {
+            pos++;
+            if (at(pos) < '0' || at(pos) > '9')
+            {
+                return 0;
+            }
+            spec.precision = 0;
+            for (; at(pos) >= '0' && at(pos) <= '9'; pos++)
+            {
+                if (spec.precision > 99)
+                {
+                    return 0;
+                }
+                spec.precision = spec.precision * 10 + (at(pos) - '0');
+            }
+        }
+        if (at(pos) != '}' && at(pos) != '\0')
+        {
+            spec.type = at(pos++);
+        }
+        return at(pos) == '}' ? pos : 0;
+    }
+
+    static constexpr bool IsValidSpec(const Spec_t &spec, ArgKind kind)
+    {
+        constexpr std::string_view kIntegerTypes = "dxXbo";
+        constexpr std::string_view kFloatTypes = "feg";
+        bool is_integer_type = spec.type != '\0' && kIntegerTypes.find(spec.type) != std::string_view::npos;
+        switch (kind)
+        {
+            case ArgKind::kSigned:
+            case ArgKind::kUnsigned:
+                return spec.precision < 0 && (spec.type == '\0' || is_integer_type);
+            case ArgKind::kChar:
+                return spec.precision < 0 && (spec.type == '\0' || spec.type == 'c' || is_integer_type) &&
+                       (!spec.zero_pad || is_integer_type);
+            case ArgKind::kFloat:
+            case ArgKind::kDouble:
+                return spec.type == '\0' || kFloatTypes.find(spec.type) != std::string_view::npos;
+            case ArgKind::kBool:
+                return spec.precision < 0 && !spec.zero_pad && (spec.type == '\0' || spec.type == 's');
+            case ArgKind::kString:
+                return !spec.zero_pad && (spec.type == '\0' || spec.type == 's');
+            default:
+                return false;
+        }
+    }
+
+    static void WriteArg(Writer_t &writer, const Spec_t &spec, const Arg_t &arg);
+
+    // Not constexpr, so calling them from Check() stops compilation with a readable error.
+    static void FormatStringError_UnmatchedClosingBrace() {}
+    static void FormatStringError_NotEnoughArguments() {}
+    static void FormatStringError_TooManyArguments() {}
+    static void FormatStringError_UnsupportedArgumentType() {}
+    static void FormatStringError_InvalidReplacementField() {}
+    static void FormatStringError_SpecDoesNotMatchArgumentType() {}
+};
+
+/**
+ * @brief Format string that is checked against its argument types at compile time. Constructed implicitly from a
+ * string literal when calling CppATFormatTo() or CppAT::Format().
+ */
+template <typename... Args>
+class CppATFormatString
+{
+public:
+    consteval CppATFormatString(const char *format) : format_(format)
+    {
+        constexpr CppATFormat::ArgKind kinds[sizeof...(Args) + 1] = {CppATFormat::GetArgKind<Args>()...};
+        CppATFormat::Check(format_, kinds, sizeof...(Args));
+    }
+
+    std::string_view Get() const { return format_; }
+
+private:
+    std::string_view format_;
+};
+
+/**
+ * @brief Formats into a character buffer, truncating output that doesn't fit.
+ * @param[out] buf Buffer to write to. Not null terminated.
+ * @param[in] buf_len Size of buf.
+ * @param[in] format Format string, e.g. "+TEMP: {:.1f}".
+ * @param[in] args Arguments for the replacement fields.
+ * @retval Length of the full output, which may be larger than buf_len.
+ */
+template <typename... Args>
+size_t CppATFormatTo(char *buf, size_t buf_len, CppATFormatString<std::type_identity_t<Args>...> format,
+                     const Args &...args)
+{
+    const CppATFormat::Arg_t arg_list[sizeof...(Args) + 1] = {CppATFormat::MakeArg(args)...};
+    return CppATFormat::Format(buf, buf_len, format.Get(), arg_list);
+}
+
+#endif /* _CPP_AT_FORMAT_HH_ */
@@ -0,0 +1,184 @@
+#include "cpp_at_frame.hh"
+
+#include <array>
+#include <charconv> // for std::from_chars, std::to_chars
+#include <cstring>  // for memcpy
+#include <limits>
+
+#if CPP_AT_FRAME_HW_CRC && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CPP_AT_FRAME_X86_CRC 1
+#include <immintrin.h>
+#else
+#define CPP_AT_FRAME_X86_CRC 0
+#endif
+
+#if CPP_AT_FRAME_HW_CRC && defined(__ARM_FEATURE_CRC32)
+#define CPP_AT_FRAME_ARM_CRC 1
+#include <arm_acle.h>
+#else
+#define CPP_AT_FRAME_ARM_CRC 0
+#endif
+
+namespace
+{
+
+constexpr uint32_t kCrc32cPolynomial = 0x82F63B78; // Reversed Castagnoli polynomial.
+
+constexpr std::array<uint32_t, 256> MakeCrc32cTable()
+{
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = crc & 1 ? (crc >> 1) ^ kCrc32cPolynomial : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> kCrc32cTable = MakeCrc32cTable();
+
+uint32_t Crc32cTable(const uint8_t *data, size_t len, uint32_t crc)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        crc = kCrc32cTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if CPP_AT_FRAME_X86_CRC
+__attribute__((target("sse4.2"))) uint32_t Crc32cSse42(const uint8_t *data, size_t len, uint32_t crc)
+{
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    for (; len >= 8; data += 8, len -= 8)
+    {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    for (; len >= 4; data += 4, len -= 4)
+    {
+        uint32_t word;
+        memcpy(&word, data, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+    for (; len > 0; data++, len--)
+    {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+    return crc;
+}
+#endif
+
+#if CPP_AT_FRAME_ARM_CRC
+uint32_t Crc32cArm(const uint8_t *data, size_t len, uint32_t crc)
+{
+    for (; len >= 8; data += 8, len -= 8)
+    {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc = __crc32cd(crc, word);
+    }
+    for (; len > 0; data++, len--)
+    {
+        crc = __crc32cb(crc, *data);
+    }
+    return crc;
+}
+#endif
+
+} // namespace
+
+/**
+ * CppATFrame Public Functions
+ */
+
+uint32_t CppATFrame::Crc32c(std::string_view data, uint32_t crc)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.data());
+    crc = ~crc;
+#if CPP_AT_FRAME_X86_CRC
+    static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+    if (has_sse42)
+    {
+        return ~Crc32cSse42(bytes, data.length(), crc);
+    }
+#elif CPP_AT_FRAME_ARM_CRC
+    return ~Crc32cArm(bytes, data.length(), crc);
+#endif
+    return ~Crc32cTable(bytes, data.length(), crc);
+}
+
+bool CppATFrame::Unframe(std::string_view line, std::string_view &payload)
+{
+    size_t end = line.find_last_not_of("\r\n");
+    if (end == std::string_view::npos)
+    {
+        return false;
+    }
+    line = line.substr(0, end + 1);
+    size_t trailer_start = line.rfind(kTrailerStart);
+    if (trailer_start == std::string_view::npos)
+    {
+        return false;
+    }
+
+    // Length first, so truncated or merged lines are rejected without computing a CRC.
+    const char *ptr = line.data() + trailer_start + 1;
+    const char *line_end = line.data() + line.length();
+    size_t length;
+    auto [length_end, length_error] = std::from_chars(ptr, line_end, length);
+    if (length_error != std::errc() || length_end == ptr || length != trailer_start || length_end == line_end ||
+        *length_end != kLengthDelimiter)
+    {
+        return false;
+    }
+    ptr = length_end + 1;
+    uint32_t crc;
+    auto [crc_end, crc_error] = std::from_chars(ptr, line_end, crc, 16);
+    if (crc_error != std::errc() || crc_end != line_end || crc_end - ptr != 8)
+    {
+        return false;
+    }
+    if (Crc32c(line.substr(0, trailer_start)) != crc)
+    {
+        return false;
+    }
+    payload = line.substr(0, trailer_start);
+    return true;
+}
+
+static_assert(CppATFrame::kTrailerMaxLen >= 1 + std::numeric_limits<size_t>::digits10 + 1 + 1 + 8,
+              "kTrailerMaxLen must hold the longest length field and the CRC.");
+
+size_t CppATFrame::WriteTrailer(std::string_view payload, char *buf, size_t buf_len)
+{
+    static constexpr char kHexDigits[] = "0123456789ABCDEF";
+    char trailer[kTrailerMaxLen];
+    trailer[0] = kTrailerStart;
+    auto [ptr, error] = std::to_chars(trailer + 1, trailer + sizeof(trailer), payload.length());
+    if (error != std::errc() || trailer + sizeof(trailer) - ptr < 9) // Room for the delimiter and the CRC.
+    {
+        return 0;
+    }
+    *ptr++ = kLengthDelimiter;
+    uint32_t crc = Crc32c(payload);
+    for (int shift = 28; shift >= 0; shift -= 4)
+    {
+        *ptr++ = kHexDigits[(crc >> shift) & 0xF];
+    }
+    size_t trailer_len = ptr - trailer;
+    if (trailer_len > buf_len)
+    {
+        return 0;
+    }
+    memcpy(buf, trailer, trailer_len);
+    return trailer_len;
+}
@@ -0,0 +1,98 @@
+#ifndef _CPP_AT_FRAME_HH_
+#define _CPP_AT_FRAME_HH_
+
+#include <string_view>
+#include "cpp_at.hh"
+#include "cpp_at_output.hh"
+#include "cpp_at_settings.hh"
+#include "stdint.h"
+
+/**
+ * @brief Integrity framing for noisy links. A framed line carries a trailer with the length and CRC32C of the text in
+ * front of it, e.g. "AT+VOLT=12*10:1A2B3C4D\r\n" (length in decimal, CRC as 8 hex digits). Lines whose trailer
+ * doesn't match are rejected before they reach the parser, and responses get a trailer of their own so the host can
+ * check them too.
+ *
+ * The CRC uses the SSE4.2 crc32 instruction when the CPU has it, the ARMv8 CRC32 extension when it is enabled at
+ * compile time, and a 1 KiB lookup table otherwise.
+ */
+class CppATFrame
+{
+public:
+    static constexpr char kTrailerStart = '*';
+    static constexpr char kLengthDelimiter = ':';
+    static constexpr uint16_t kTrailerMaxLen = 30; // "*" + up to 20 length digits + ":" + 8 CRC digits.
+    static constexpr char kErrorResponse[] = "ERROR CRC\r\n"; // Response to lines with a bad trailer.
+
+    /**
+     * @brief Computes the CRC32C (Castagnoli) of a block of data.
+     * @param[in] data Data to checksum.
+     * @param[in] crc CRC of the data before this block, to checksum data in pieces.
+     * @retval CRC32C of all the data so far.
+     */
+    static uint32_t Crc32c(std::string_view data, uint32_t crc = 0);
+
+    /**
+     * @brief Checks the trailer of a framed line and returns the text it protects.
+     * @param[in] line Received line. Any line ending after the trailer is ignored.
+     * @param[out] payload Text in front of the trailer, only valid if the frame is good.
+     * @retval True if the trailer is well formed and matches the payload, false otherwise.
+     */
+    static bool Unframe(std::string_view line, std::string_view &payload);
+
+    /**
+     * @brief Writes the trailer for a block of text, without a line ending.
+     * @param[in] payload Text to protect.
+     * @param[out] buf Destination for the trailer. Should hold at least kTrailerMaxLen characters.
+     * @param[in] buf_len Size of buf.
+     * @retval Length of the trailer, or 0 if it doesn't fit in buf.
+     */
+    static size_t WriteTrailer(std::string_view payload, char *buf, size_t buf_len);
+};
+
+/**
+ * @brief Runs a framed line through a parser. Bad frames are answered with CppATFrame::kErrorResponse without being
+ * looked up or tokenized. The response is followed by a trailer line ("*<length>:<crc>\r\n") covering everything the
+ * command printed, including the response to a bad frame.
+ * @param[in] parser CppAT parser to run the payload with.
+ * @param[in] line Received line including its trailer.
+ * @retval Result of ParseMessage, or false if the frame was bad.
+ */
+template <typename Parser>
+bool CppATParseFramedMessage(Parser &parser, std::string_view line)
+{
+    CppATOutputBuffer *output = CppATOutputBuffer::GetActive();
+    char local_buf[CPP_AT_FRAME_RESPONSE_LEN + 1]; // Leave room for '\0' written by vsnprintf.
+    CppATOutputBuffer local_output(local_buf, sizeof(local_buf));
+    if (output == nullptr)
+    {
+        output = &local_output; // Collect the response so its CRC can be computed before it is sent.
+    }
+    size_t start = output->GetLength();
+
+    bool result = false;
+    std::string_view payload;
+    if (CppATFrame::Unframe(line, payload))
+    {
+        CppATOutputBuffer::Scope scope(*output);
+        result = parser.ParseMessage(payload);
+    }
+    else
+    {
+        output->Write(CppATFrame::kErrorResponse, sizeof(CppATFrame::kErrorResponse) - 1);
+    }
+
+    char trailer[CppATFrame::kTrailerMaxLen + 2];
+    size_t trailer_len = CppATFrame::WriteTrailer(output->GetContents().substr(start), trailer, sizeof(trailer) - 2);
+    trailer[trailer_len++] = '\r';
+    trailer[trailer_len++] = '\n';
+    output->Write(trailer, trailer_len);
+    if (output == &local_output)
+    {
+        std::string_view response = local_output.GetContents();
+        CppAT::Printf("%.*s", static_cast<int>(response.length()), response.data());
+    }
+    return result;
+}
+
+#endif /* _CPP_AT_FRAME_HH_ */
@@ -0,0 +1,110 @@
+#ifndef _CPP_AT_FUNCTION_HH_
+#define _CPP_AT_FUNCTION_HH_
+
+#include <cstddef> // for std::size_t, std::max_align_t
+#include <functional>
+#include <new>         // for placement new
+#include <type_traits> // for std::decay_t, std::is_invocable_r_v
+#include <utility>     // for std::forward, std::move
+#include "cpp_at_settings.hh"
+
+template <typename Signature, std::size_t kCapacity>
+class CppATInplaceFunction;
+
+/**
+ * @brief Fixed capacity replacement for std::function that never allocates. Callables are stored in an internal buffer
+ * of kCapacity bytes; trying to store a callable that doesn't fit is a compile time error.
+ */
+template <typename R, typename... Args, std::size_t kCapacity>
+class CppATInplaceFunction<R(Args...), kCapacity>
+{
+public:
+    CppATInplaceFunction() {}
+    CppATInplaceFunction(std::nullptr_t) {}
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, CppATInplaceFunction> &&
+                                                      std::is_invocable_r_v<R, std::decay_t<F> &, Args...>>>
+    CppATInplaceFunction(F &&f)
+    {
+        using Callable = std::decay_t<F>;
+        static_assert(sizeof(Callable) <= kCapacity,
+                      "Callable is too large for CppATInplaceFunction, increase CPP_AT_CALLBACK_MAX_SIZE.");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "Callable is over-aligned.");
+        new (storage_) Callable(std::forward<F>(f));
+        invoke_ = [](void *storage, Args... args) -> R
+        { return (*static_cast<Callable *>(storage))(std::forward<Args>(args)...); };
+        manage_ = [](void *dst, void *src, bool destroy)
+        {
+            if (destroy)
+            {
+                static_cast<Callable *>(dst)->~Callable();
+            }
+            else
+            {
+                new (dst) Callable(*static_cast<const Callable *>(src));
+            }
+        };
+    }
+
+    CppATInplaceFunction(const CppATInplaceFunction &other) { CopyFrom(other); }
+
+    CppATInplaceFunction &operator=(const CppATInplaceFunction &other)
+    {
+        if (this != &other)
+        {
+            Reset();
+            CopyFrom(other);
+        }
+        return *this;
+    }
+
+    CppATInplaceFunction &operator=(std::nullptr_t)
+    {
+        Reset();
+        return *this;
+    }
+
+    ~CppATInplaceFunction() { Reset(); }
+
+    explicit operator bool() const { return invoke_ != nullptr; }
+
+    R operator()(Args... args) const { return invoke_(storage_, std::forward<Args>(args)...); }
+
+private:
+    void CopyFrom(const CppATInplaceFunction &other)
+    {
+        if (other.invoke_ != nullptr)
+        {
+            other.manage_(storage_, other.storage_, false);
+            invoke_ = other.invoke_;
+            manage_ = other.manage_;
+        }
+    }
+
+    void Reset()
+    {
+        if (invoke_ != nullptr)
+        {
+            manage_(storage_, nullptr, true);
+            invoke_ = nullptr;
+            manage_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) mutable unsigned char storage_[kCapacity];
+    R (*invoke_)(void *, Args...) = nullptr;
+    void (*manage_)(void *, void *, bool) = nullptr;
+};
+
+/**
+ * Callable type used for CppAT callbacks. Resolves to std::function unless the heap-free build profile is enabled.
+ */
+#if CPP_AT_HEAP_FREE
+template <typename Signature>
+using CppATFunction = CppATInplaceFunction<Signature, CPP_AT_CALLBACK_MAX_SIZE>;
+#else
+template <typename Signature>
+using CppATFunction = std::function<Signature>;
+#endif
+
+#endif /* _CPP_AT_FUNCTION_HH_ */
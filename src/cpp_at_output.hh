@@ -0,0 +1,158 @@
+#ifndef _CPP_AT_OUTPUT_HH_
+#define _CPP_AT_OUTPUT_HH_
+
+#include <cstdarg> // for va_list
+#include <cstdio>  // for vsnprintf
+#include <cstring> // for memcpy, memmove
+#include <string_view>
+#include "cpp_at_format.hh"
+#include "cpp_at_settings.hh"
+#include "stdint.h"
+
+/**
+ * @brief Fixed capacity buffer that collects the output of CppAT for a single session. While a buffer is active on a
+ * thread, everything printed through CppAT::Printf (including the CPP_AT_* response macros) is appended to it instead
+ * of being sent to cpp_at_printf. Transports use this to send responses back to the right port.
+ */
+class CppATOutputBuffer
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param[in] buf Storage for the buffer contents. One byte is reserved for the '\0' written by vsnprintf.
+     * @param[in] buf_len Size of buf in bytes.
+     */
+    CppATOutputBuffer(char *buf, size_t buf_len) : buf_(buf), capacity_(buf_len > 0 ? buf_len - 1 : 0) {}
+
+    /**
+     * @brief Makes a buffer the active output for the current thread for as long as the Scope exists.
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(CppATOutputBuffer &buffer) : previous_(active_) { active_ = &buffer; }
+        ~Scope() { active_ = previous_; }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        CppATOutputBuffer *previous_;
+    };
+
+    /**
+     * @brief Returns the active output buffer for the current thread, or nullptr if there isn't one.
+     */
+    static CppATOutputBuffer *GetActive() { return active_; }
+
+    /**
+     * @brief Appends raw bytes. Bytes that don't fit are dropped and counted in GetNumDropped().
+     * @param[in] data Bytes to append.
+     * @param[in] len Number of bytes to append.
+     * @retval Number of bytes appended.
+     */
+    size_t Write(const char *data, size_t len)
+    {
+        size_t available = capacity_ - len_;
+        if (len > available)
+        {
+            num_dropped_ += len - available;
+            len = available;
+        }
+        memcpy(buf_ + len_, data, len);
+        len_ += len;
+        return len;
+    }
+
+    /**
+     * @brief printf into the buffer. Output that doesn't fit is dropped and counted in GetNumDropped().
+     * @retval The number of characters that the formatted output would have had.
+     */
+    int Printf(const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        int res = VPrintf(format, args);
+        va_end(args);
+        return res;
+    }
+
+    int VPrintf(const char *format, va_list args)
+    {
+        int res = vsnprintf(buf_ + len_, capacity_ - len_ + 1, format, args);
+        if (res > 0)
+        {
+            size_t available = capacity_ - len_;
+            if (static_cast<size_t>(res) > available)
+            {
+                num_dropped_ += res - available;
+                len_ = capacity_;
+            }
+            else
+            {
+                len_ += res;
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief Formats straight into the free space of the buffer. Output that doesn't fit is dropped and counted in
+     * GetNumDropped().
+     * @param[in] format Format string, checked at compile time.
+     * @param[in] args Arguments for the replacement fields.
+     * @retval The number of characters that the formatted output would have had.
+     */
+    template <typename... Args>
+    size_t Format(CppATFormatString<std::type_identity_t<Args>...> format, const Args &...args)
+    {
+        const CppATFormat::Arg_t arg_list[sizeof...(Args) + 1] = {CppATFormat::MakeArg(args)...};
+        CppATFormat::Writer_t writer = {.buf = buf_ + len_, .capacity = capacity_ - len_};
+        CppATFormat::Format(writer, format.Get(), arg_list);
+        len_ += writer.len;
+        num_dropped_ += writer.total_len - writer.len;
+        return writer.total_len;
+    }
+
+    /**
+     * @brief Returns the bytes that haven't been consumed yet.
+     */
+    std::string_view GetContents() const { return std::string_view(buf_, len_); }
+
+    /**
+     * @brief Removes bytes from the front of the buffer, e.g. after they have been sent.
+     * @param[in] len Number of bytes to remove.
+     */
+    void Consume(size_t len)
+    {
+        if (len >= len_)
+        {
+            len_ = 0;
+            return;
+        }
+        memmove(buf_, buf_ + len, len_ - len);
+        len_ -= len;
+    }
+
+    /**
+     * @brief Removes all contents and resets the dropped byte count.
+     */
+    void Clear()
+    {
+        len_ = 0;
+        num_dropped_ = 0;
+    }
+
+    size_t GetLength() const { return len_; }
+    size_t GetCapacity() const { return capacity_; }
+    size_t GetNumDropped() const { return num_dropped_; }
+
+private:
+    static inline CPP_AT_THREAD_LOCAL CppATOutputBuffer *active_ = nullptr;
+
+    char *buf_;
+    size_t capacity_;
+    size_t len_ = 0;
+    size_t num_dropped_ = 0;
+};
+
+#endif /* _CPP_AT_OUTPUT_HH_ */
@@ -0,0 +1,281 @@
+#include "cpp_at_profile.hh"
+
+#include <algorithm> // for std::min
+#include <cstddef>   // for offsetof
+#include "cpp_at.hh"
+#include "cpp_at_frame.hh" // for CppATFrame::Crc32c
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>    // for open
+#include <sys/mman.h> // for mmap, msync, munmap
+#include <sys/stat.h> // for fstat
+#include <unistd.h>   // for close, ftruncate, sysconf
+
+namespace
+{
+
+size_t RoundUp(size_t value, size_t multiple) { return (value + multiple - 1) / multiple * multiple; }
+
+} // namespace
+
+/**
+ * CppATProfileStore Public Functions
+ */
+
+CppATProfileStore::CppATProfileStore(size_t capacity)
+{
+    page_size_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    capacity_ = RoundUp(capacity > 0 ? capacity : 1, page_size_);
+    void *mapping = mmap(nullptr, capacity_ * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        CppAT::Printf("CppATProfileStore: Unable to allocate %zu bytes for settings.\r\n", capacity_ * 2);
+        return;
+    }
+    values_ = static_cast<uint8_t *>(mapping);
+    factory_values_ = values_ + capacity_;
+    is_valid = true;
+}
+
+CppATProfileStore::~CppATProfileStore()
+{
+    if (file_ != nullptr)
+    {
+        munmap(file_, file_len_);
+    }
+    if (fd_ >= 0)
+    {
+        close(fd_);
+    }
+    if (values_ != nullptr)
+    {
+        munmap(values_, capacity_ * 2);
+    }
+}
+
+bool CppATProfileStore::Open(const char *path)
+{
+    if (!is_valid || file_ != nullptr)
+    {
+        return false;
+    }
+    fd_ = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+    {
+        CppAT::Printf("CppATProfileStore::Open: Unable to open %s.\r\n", path);
+        return false;
+    }
+    // A file written with a different capacity is resized. Banks that moved fail their CRC check and are ignored.
+    file_len_ = (page_size_ + capacity_) * 2;
+    struct stat file_stat;
+    if (fstat(fd_, &file_stat) != 0 ||
+        (static_cast<size_t>(file_stat.st_size) != file_len_ && ftruncate(fd_, file_len_) != 0))
+    {
+        CppAT::Printf("CppATProfileStore::Open: Unable to resize %s.\r\n", path);
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    void *mapping = mmap(nullptr, file_len_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED)
+    {
+        CppAT::Printf("CppATProfileStore::Open: Unable to map %s.\r\n", path);
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    file_ = static_cast<uint8_t *>(mapping);
+    layout_hash_ = GetLayoutHash();
+
+    // A bank is only valid if its header and values match their CRC, so a bank torn by an interrupted save loses to
+    // the other one.
+    for (uint8_t bank = 0; bank < 2; bank++)
+    {
+        const BankHeader_t *header = GetBankHeader(bank);
+        if (header->magic != kMagic || header->layout_hash != layout_hash_ || header->data_len != len_ ||
+            header->crc != GetBankCrc(*header, GetBankData(bank)))
+        {
+            continue;
+        }
+        if (current_bank_ == kNoBank || header->sequence > sequence_)
+        {
+            current_bank_ = bank;
+            sequence_ = header->sequence;
+        }
+    }
+    return Restore();
+}
+
+bool CppATProfileStore::Save()
+{
+    if (file_ == nullptr)
+    {
+        return false;
+    }
+    if (current_bank_ != kNoBank && memcmp(GetBankData(current_bank_), values_, len_) == 0)
+    {
+        return true; // Nothing changed since the last save.
+    }
+
+    // The other bank holds the profile from two saves ago (or nothing), so only pages changed since then are copied.
+    uint8_t bank = current_bank_ == 0 ? 1 : 0;
+    uint8_t *data = GetBankData(bank);
+    uint8_t *run_start = nullptr; // Start of a run of changed pages that haven't been flushed yet.
+    bool flushed = true;
+    for (size_t offset = 0; offset < len_; offset += page_size_)
+    {
+        size_t page_len = std::min(page_size_, len_ - offset);
+        if (memcmp(data + offset, values_ + offset, page_len) != 0)
+        {
+            memcpy(data + offset, values_ + offset, page_len);
+            num_pages_written_++;
+            if (run_start == nullptr)
+            {
+                run_start = data + offset;
+            }
+        }
+        else if (run_start != nullptr)
+        {
+            flushed &= Flush(run_start, data + offset - run_start);
+            run_start = nullptr;
+        }
+    }
+    if (run_start != nullptr)
+    {
+        flushed &= Flush(run_start, data + len_ - run_start);
+    }
+    if (!flushed)
+    {
+        return false;
+    }
+
+    // Commit. The values are on disk before the header that makes them current.
+    BankHeader_t header = {
+        .layout_hash = layout_hash_, .sequence = sequence_ + 1, .data_len = static_cast<uint32_t>(len_)};
+    header.crc = GetBankCrc(header, data);
+    memcpy(GetBankHeader(bank), &header, sizeof(header));
+    num_pages_written_++;
+    if (!Flush(reinterpret_cast<uint8_t *>(GetBankHeader(bank)), sizeof(header)))
+    {
+        return false;
+    }
+    current_bank_ = bank;
+    sequence_ = header.sequence;
+    return true;
+}
+
+bool CppATProfileStore::Restore()
+{
+    if (file_ == nullptr)
+    {
+        return false;
+    }
+    if (current_bank_ == kNoBank)
+    {
+        FactoryReset();
+    }
+    else
+    {
+        memcpy(values_, GetBankData(current_bank_), len_);
+    }
+    return true;
+}
+
+void CppATProfileStore::FactoryReset()
+{
+    if (values_ != nullptr)
+    {
+        memcpy(values_, factory_values_, len_);
+    }
+}
+
+/**
+ * CppATProfileStore Private Functions
+ */
+
+uint8_t *CppATProfileStore::AllocateSetting(std::string_view name, size_t size, size_t alignment)
+{
+    if (!is_valid || file_ != nullptr)
+    {
+        CppAT::Printf("CppATProfileStore::AddSetting: Can't add setting %.*s after Open().\r\n",
+                      static_cast<int>(name.length()), name.data());
+        return nullptr;
+    }
+    size_t offset = RoundUp(len_, alignment);
+    if (num_settings_ >= kMaxNumSettings || offset + size > capacity_)
+    {
+        CppAT::Printf("CppATProfileStore::AddSetting: No room for setting %.*s.\r\n",
+                      static_cast<int>(name.length()), name.data());
+        return nullptr;
+    }
+    settings_[num_settings_++] = {
+        .name = name, .offset = static_cast<uint32_t>(offset), .size = static_cast<uint32_t>(size)};
+    len_ = offset + size;
+    return values_ + offset;
+}
+
+uint32_t CppATProfileStore::GetLayoutHash() const
+{
+    uint32_t hash = 0;
+    for (uint16_t i = 0; i < num_settings_; i++)
+    {
+        hash = CppATFrame::Crc32c(settings_[i].name, hash);
+        hash = CppATFrame::Crc32c(
+            std::string_view(reinterpret_cast<const char *>(&settings_[i].size), sizeof(settings_[i].size)), hash);
+    }
+    return hash;
+}
+
+uint8_t *CppATProfileStore::GetBankData(uint8_t bank) const
+{
+    return file_ + bank * (page_size_ + capacity_) + page_size_;
+}
+
+CppATProfileStore::BankHeader_t *CppATProfileStore::GetBankHeader(uint8_t bank) const
+{
+    return reinterpret_cast<BankHeader_t *>(file_ + bank * (page_size_ + capacity_));
+}
+
+uint32_t CppATProfileStore::GetBankCrc(const BankHeader_t &header, const uint8_t *data) const
+{
+    uint32_t crc = CppATFrame::Crc32c(std::string_view(reinterpret_cast<const char *>(data), header.data_len));
+    return CppATFrame::Crc32c(std::string_view(reinterpret_cast<const char *>(&header), offsetof(BankHeader_t, crc)),
+                              crc);
+}
+
+bool CppATProfileStore::Flush(uint8_t *start, size_t len)
+{
+    // msync needs a page aligned address, but only the pages touched by [start, start + len) are written.
+    uint8_t *page_start = file_ + (start - file_) / page_size_ * page_size_;
+    if (msync(page_start, start + len - page_start, MS_SYNC) != 0)
+    {
+        CppAT::Printf("CppATProfileStore::Save: Unable to write profile.\r\n");
+        return false;
+    }
+    return true;
+}
+
+#else
+
+// Without mmap there is no memory for settings, so AddSetting() fails and the store can't be opened.
+
+CppATProfileStore::CppATProfileStore(size_t) {}
+
+CppATProfileStore::~CppATProfileStore() {}
+
+bool CppATProfileStore::Open(const char *)
+{
+    CppAT::Printf("CppATProfileStore::Open: Not supported on this platform.\r\n");
+    return false;
+}
+
+bool CppATProfileStore::Save() { return false; }
+
+bool CppATProfileStore::Restore() { return false; }
+
+void CppATProfileStore::FactoryReset() {}
+
+uint8_t *CppATProfileStore::AllocateSetting(std::string_view, size_t, size_t) { return nullptr; }
+
+#endif
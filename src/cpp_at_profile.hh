@@ -0,0 +1,148 @@
+#ifndef _CPP_AT_PROFILE_HH_
+#define _CPP_AT_PROFILE_HH_
+
+#include <array>
+#include <cstring> // for memcpy
+#include <string_view>
+#include <type_traits>
+#include "cpp_at_profile_interface.hh"
+#include "cpp_at_settings.hh"
+#include "stdint.h"
+
+/**
+ * @brief Persistent settings profile shared by command handlers. Handlers register typed settings with AddSetting()
+ * and read and write them through the returned pointer, so using a setting is a plain memory access. Saved profiles
+ * live in a memory mapped file holding two banks: a save copies the settings into the bank that isn't current,
+ * writing only the pages that differ from what that bank already holds, then commits by writing the bank's header
+ * with a higher sequence number. A save interrupted at any point leaves the previous profile intact.
+ *
+ * Attach a store to a parser with SetProfileStore() to enable the standard AT&W (save), ATZ (restore saved) and AT&F
+ * (restore factory values) commands. POSIX only.
+ */
+class CppATProfileStore : public CppATProfileInterface
+{
+public:
+    static constexpr uint16_t kMaxNumSettings = CPP_AT_PROFILE_MAX_NUM_SETTINGS;
+    static constexpr uint32_t kMagic = 0x50544143; // "CATP" in little endian.
+
+    /**
+     * @brief Constructor. Reserves memory for the current and factory values of the settings.
+     * @param[in] capacity Maximum total size of the settings in bytes. Rounded up to a whole number of pages.
+     */
+    explicit CppATProfileStore(size_t capacity = CPP_AT_PROFILE_CAPACITY);
+
+    /**
+     * @brief Destructor. Unmaps the profile file without saving.
+     */
+    ~CppATProfileStore();
+
+    CppATProfileStore(const CppATProfileStore &) = delete;
+    CppATProfileStore &operator=(const CppATProfileStore &) = delete;
+
+    /**
+     * @brief Registers a setting. Must be called before Open(), always in the same order: a profile saved with a
+     * different set of settings is ignored and the factory values are used instead.
+     * @param[in] name Name of the setting, used to detect layout changes. Must outlive the store.
+     * @param[in] factory_value Value used before a profile is saved, and restored by FactoryReset().
+     * @retval Pointer to the current value, or nullptr if there is no room or the store is already open.
+     */
+    template <typename T>
+    T *AddSetting(std::string_view name, const T &factory_value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Settings are saved byte for byte.");
+        uint8_t *value = AllocateSetting(name, sizeof(T), alignof(T));
+        if (value == nullptr)
+        {
+            return nullptr;
+        }
+        memcpy(value, &factory_value, sizeof(T));
+        memcpy(value + (factory_values_ - values_), &factory_value, sizeof(T));
+        return reinterpret_cast<T *>(value);
+    }
+
+    /**
+     * @brief Maps the profile file, creating it if needed, and loads the most recently saved profile.
+     * @param[in] path Path to the profile file.
+     * @retval True if the file was mapped, false otherwise. Finding no valid saved profile isn't an error.
+     */
+    bool Open(const char *path);
+
+    /**
+     * @brief Saves the current values of all settings. Does nothing if they match the current saved profile.
+     * @retval True if the profile was saved, false if the store isn't open or the file couldn't be written.
+     */
+    bool Save() override;
+
+    /**
+     * @brief Replaces the current values with the most recently saved profile, or with the factory values if no
+     * profile was saved.
+     * @retval True if successful, false if the store isn't open.
+     */
+    bool Restore() override;
+
+    /**
+     * @brief Replaces the current values with the factory values. Doesn't change the saved profile.
+     */
+    void FactoryReset() override;
+
+    /**
+     * @brief Returns the number of settings registered with AddSetting().
+     */
+    uint16_t GetNumSettings() const { return num_settings_; }
+
+    /**
+     * @brief Returns the total number of pages written to the profile file by Save(), including bank headers.
+     */
+    uint64_t GetNumPagesWritten() const { return num_pages_written_; }
+
+    /**
+     * @brief Returns the sequence number of the current saved profile, or 0 if none was saved.
+     */
+    uint64_t GetSequence() const { return sequence_; }
+
+    bool is_valid = false;
+
+private:
+    struct Setting_t
+    {
+        std::string_view name;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    struct BankHeader_t
+    {
+        uint32_t magic = kMagic;
+        uint32_t layout_hash = 0; // CRC32C of the setting names and sizes.
+        uint64_t sequence = 0;    // Incremented by every save, the valid bank with the highest sequence is current.
+        uint32_t data_len = 0;    // Number of bytes of setting values following the header page.
+        uint32_t crc = 0;         // CRC32C of the values and the header fields above.
+    };
+
+    uint8_t *AllocateSetting(std::string_view name, size_t size, size_t alignment);
+    uint32_t GetLayoutHash() const;
+    uint8_t *GetBankData(uint8_t bank) const;
+    BankHeader_t *GetBankHeader(uint8_t bank) const;
+    uint32_t GetBankCrc(const BankHeader_t &header, const uint8_t *data) const;
+    bool Flush(uint8_t *start, size_t len);
+
+    static constexpr uint8_t kNoBank = 0xFF;
+
+    size_t page_size_ = 0;
+    size_t capacity_ = 0; // Size of the values of each bank, a multiple of page_size_.
+    size_t len_ = 0;      // Bytes of capacity_ used by settings.
+    uint8_t *values_ = nullptr;         // Current values, anonymous memory.
+    uint8_t *factory_values_ = nullptr; // Factory values, directly after values_.
+    std::array<Setting_t, kMaxNumSettings> settings_;
+    uint16_t num_settings_ = 0;
+
+    int fd_ = -1;
+    uint8_t *file_ = nullptr; // Profile file mapping: header page and values for bank 0, then the same for bank 1.
+    size_t file_len_ = 0;
+    uint32_t layout_hash_ = 0;
+    uint8_t current_bank_ = kNoBank;
+    uint64_t sequence_ = 0;
+    uint64_t num_pages_written_ = 0;
+};
+
+#endif /* _CPP_AT_PROFILE_HH_ */
@@ -0,0 +1,32 @@
+#ifndef _CPP_AT_PROFILE_INTERFACE_HH_
+#define _CPP_AT_PROFILE_INTERFACE_HH_
+
+/**
+ * @brief Operations behind the AT&W, ATZ and AT&F commands. The parser only calls a profile through this interface, so
+ * cpp_at.cc doesn't depend on cpp_at_profile.cc unless a CppATProfileStore is actually used.
+ */
+class CppATProfileInterface
+{
+public:
+    /**
+     * @brief Saves the current settings.
+     * @retval True if successful, false otherwise.
+     */
+    virtual bool Save() = 0;
+
+    /**
+     * @brief Replaces the current settings with the saved ones.
+     * @retval True if successful, false otherwise.
+     */
+    virtual bool Restore() = 0;
+
+    /**
+     * @brief Replaces the current settings with the factory values.
+     */
+    virtual void FactoryReset() = 0;
+
+protected:
+    ~CppATProfileInterface() = default;
+};
+
+#endif /* _CPP_AT_PROFILE_INTERFACE_HH_ */
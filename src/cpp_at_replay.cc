@@ -0,0 +1,292 @@
+#include "cpp_at_replay.hh"
+
+#include <algorithm> // for std::min, std::sort
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>    // for open
+#include <sys/mman.h> // for mmap, munmap, madvise
+#include <sys/stat.h> // for fstat
+#include <thread>
+#include <unistd.h> // for close
+#include <unordered_map>
+#include "cpp_at.hh"
+
+namespace
+{
+
+struct Line_t
+{
+    std::string_view text;
+    std::string_view command;
+};
+
+struct WorkerResult_t
+{
+    std::unordered_map<std::string_view, CppATReplay::CommandStats_t> stats;
+    std::vector<Line_t> lines; // Only filled in kOrdered mode.
+    uint64_t num_lines = 0;
+    uint64_t num_skipped = 0;
+    uint64_t num_failures = 0;
+};
+
+uint64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * @brief Calls line_callback with every AT command line in chunk, and counts non-empty lines without a command.
+ */
+template <typename F>
+void TokenizeChunk(std::string_view chunk, WorkerResult_t &result, F line_callback)
+{
+    size_t start = 0;
+    while (start < chunk.length())
+    {
+        size_t end = chunk.find('\n', start);
+        if (end == std::string_view::npos)
+        {
+            end = chunk.length();
+        }
+        std::string_view line = chunk.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        std::string_view command;
+        if (CppATReplay::GetLineCommand(line, command))
+        {
+            result.num_lines++;
+            line_callback(Line_t{.text = line, .command = command});
+        }
+        else if (!line.empty())
+        {
+            result.num_skipped++;
+        }
+        start = end + 1;
+    }
+}
+
+/**
+ * @brief Runs a line through handler (if any) and records its statistics.
+ */
+void DispatchLine(const Line_t &line, const CppATReplay::LineHandler &handler, WorkerResult_t &result)
+{
+    CppATReplay::CommandStats_t &stats = result.stats[line.command];
+    stats.num_calls++;
+    if (!handler)
+    {
+        return;
+    }
+    uint64_t start_ns = NowNs();
+    bool success = handler(line.text);
+    uint64_t elapsed_ns = NowNs() - start_ns;
+    stats.total_ns += elapsed_ns;
+    stats.max_ns = std::max(stats.max_ns, elapsed_ns);
+    if (!success)
+    {
+        stats.num_failures++;
+        result.num_failures++;
+    }
+}
+
+} // namespace
+
+/**
+ * Public Functions
+ */
+
+CppATReplay::~CppATReplay() { Unmap(); }
+
+bool CppATReplay::Open(const char *path)
+{
+    Unmap();
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        CppAT::Printf("CppATReplay::Open: Unable to open %s.\r\n", path);
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0)
+    {
+        CppAT::Printf("CppATReplay::Open: Unable to stat %s.\r\n", path);
+        close(fd);
+        return false;
+    }
+    mapping_len_ = file_stat.st_size;
+    if (mapping_len_ > 0)
+    {
+        mapping_ = mmap(nullptr, mapping_len_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping_ == MAP_FAILED)
+        {
+            CppAT::Printf("CppATReplay::Open: Unable to map %s.\r\n", path);
+            mapping_ = nullptr;
+            mapping_len_ = 0;
+            close(fd);
+            return false;
+        }
+        // Captures are read front to back by each worker.
+        madvise(mapping_, mapping_len_, MADV_SEQUENTIAL);
+    }
+    close(fd); // Mapping stays valid after the file descriptor is closed.
+    capture_ = std::string_view(static_cast<const char *>(mapping_), mapping_len_);
+    return true;
+}
+
+void CppATReplay::SetCapture(std::string_view capture)
+{
+    Unmap();
+    capture_ = capture;
+}
+
+std::vector<std::string_view> CppATReplay::SplitChunks(uint16_t num_chunks) const
+{
+    std::vector<std::string_view> chunks;
+    if (num_chunks == 0)
+    {
+        num_chunks = 1;
+    }
+    size_t target_len = capture_.length() / num_chunks + 1;
+    size_t start = 0;
+    while (start < capture_.length())
+    {
+        size_t end = start + target_len;
+        if (end >= capture_.length())
+        {
+            end = capture_.length();
+        }
+        else
+        {
+            // Only split after a line ending, so that no line is cut in half.
+            end = capture_.find('\n', end);
+            end = end == std::string_view::npos ? capture_.length() : end + 1;
+        }
+        chunks.push_back(capture_.substr(start, end - start));
+        start = end;
+    }
+    return chunks;
+}
+
+CppATReplay::Summary_t CppATReplay::Run(const LineHandlerFactory &factory, uint16_t num_threads, Mode mode)
+{
+    uint64_t start_ns = NowNs();
+    if (num_threads == 0)
+    {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Use more chunks than threads so that workers that finish early can pick up more work.
+    // Clamped, since num_threads * 4 doesn't fit a uint16_t for very large thread counts.
+    uint16_t num_chunks = static_cast<uint16_t>(std::min<uint32_t>(num_threads * 4u, UINT16_MAX));
+    std::vector<std::string_view> chunks = SplitChunks(num_chunks);
+    std::vector<WorkerResult_t> results(chunks.size());
+    std::atomic<size_t> next_chunk = 0;
+
+    // kPerChunk dispatches while tokenizing, kOrdered only tokenizes here.
+    std::vector<std::thread> workers;
+    for (uint16_t worker_index = 0; worker_index < std::min<size_t>(num_threads, chunks.size()); worker_index++)
+    {
+        workers.emplace_back(
+            [&, worker_index]()
+            {
+                LineHandler handler = nullptr;
+                if (mode == Mode::kPerChunk && factory)
+                {
+                    handler = factory(worker_index);
+                }
+                for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++)
+                {
+                    WorkerResult_t &result = results[i];
+                    if (mode == Mode::kPerChunk)
+                    {
+                        TokenizeChunk(chunks[i], result,
+                                      [&](const Line_t &line) { DispatchLine(line, handler, result); });
+                    }
+                    else
+                    {
+                        TokenizeChunk(chunks[i], result, [&](const Line_t &line) { result.lines.push_back(line); });
+                    }
+                }
+            });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    if (mode == Mode::kOrdered)
+    {
+        // Chunks are in capture order, so dispatching them one after another preserves the order of the capture. This
+        // part is serial by design, since every line goes through the same parser.
+        LineHandler handler = factory ? factory(0) : nullptr;
+        for (WorkerResult_t &result : results)
+        {
+            for (const Line_t &line : result.lines)
+            {
+                DispatchLine(line, handler, result);
+            }
+            result.lines.clear();
+            result.lines.shrink_to_fit();
+        }
+    }
+
+    // Merge statistics from all chunks.
+    Summary_t summary = {.num_bytes = capture_.length()};
+    std::unordered_map<std::string_view, CommandStats_t> merged_stats;
+    for (const WorkerResult_t &result : results)
+    {
+        summary.num_lines += result.num_lines;
+        summary.num_skipped += result.num_skipped;
+        summary.num_failures += result.num_failures;
+        for (const auto &[command, stats] : result.stats)
+        {
+            CommandStats_t &merged = merged_stats[command];
+            merged.num_calls += stats.num_calls;
+            merged.num_failures += stats.num_failures;
+            merged.total_ns += stats.total_ns;
+            merged.max_ns = std::max(merged.max_ns, stats.max_ns);
+        }
+    }
+    command_stats_.clear();
+    for (auto &[command, stats] : merged_stats)
+    {
+        stats.command = std::string(command);
+        command_stats_.push_back(stats);
+    }
+    std::sort(command_stats_.begin(), command_stats_.end(),
+              [](const CommandStats_t &a, const CommandStats_t &b) { return a.command < b.command; });
+
+    summary.wall_ns = NowNs() - start_ns;
+    return summary;
+}
+
+bool CppATReplay::GetLineCommand(std::string_view line, std::string_view &command)
+{
+    // Only lines that start with the prefix are commands, so responses and logs containing "AT" are skipped.
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string_view::npos || line.substr(start, CppAT::kATPrefixLen) != CppAT::kATPrefix)
+    {
+        return false;
+    }
+    start += CppAT::kATPrefixLen;
+    size_t end = line.find_first_of(CppAT::kATAllowedOpChars, start);
+    command = line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+    return !command.empty();
+}
+
+/**
+ * Private Functions
+ */
+
+void CppATReplay::Unmap()
+{
+    if (mapping_ != nullptr)
+    {
+        munmap(mapping_, mapping_len_);
+        mapping_ = nullptr;
+        mapping_len_ = 0;
+    }
+    capture_ = std::string_view();
+}
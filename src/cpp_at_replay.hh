@@ -0,0 +1,111 @@
+#ifndef _CPP_AT_REPLAY_HH_
+#define _CPP_AT_REPLAY_HH_
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "stdint.h"
+
+/**
+ * @brief Offline processor for captured AT traffic. Memory maps a capture, splits it into chunks on line boundaries
+ * and dispatches the AT command lines in each chunk in parallel, collecting per-command statistics.
+ */
+class CppATReplay
+{
+public:
+    /**
+     * Function that executes a single line, usually a lambda that calls ParseMessage on a parser.
+     */
+    using LineHandler = std::function<bool(std::string_view line)>;
+    /**
+     * Function that creates a LineHandler for a worker thread. Parsers are not thread safe, so each worker needs its
+     * own parser.
+     */
+    using LineHandlerFactory = std::function<LineHandler(uint16_t worker_index)>;
+
+    enum class Mode : uint8_t
+    {
+        kPerChunk = 0, // Each worker tokenizes and dispatches its own chunk with its own parser.
+        kOrdered = 1   // Workers tokenize chunks in parallel, then lines are dispatched in capture order on one parser.
+                       // Dispatch is serial and every command line is buffered until then, so only use it for
+                       // captures whose commands depend on the ones before them.
+    };
+
+    struct CommandStats_t
+    {
+        std::string command;       // Command text after the AT prefix, e.g. "+CFG".
+        uint64_t num_calls = 0;    // Number of lines that invoked the command.
+        uint64_t num_failures = 0; // Number of lines where the LineHandler returned false.
+        uint64_t total_ns = 0;     // Total time spent in the LineHandler.
+        uint64_t max_ns = 0;       // Longest time spent in the LineHandler for a single line.
+    };
+
+    struct Summary_t
+    {
+        uint64_t num_bytes = 0;    // Size of the capture.
+        uint64_t num_lines = 0;    // Number of lines containing an AT command.
+        uint64_t num_skipped = 0;  // Number of non-empty lines without an AT command (e.g. responses).
+        uint64_t num_failures = 0; // Number of AT command lines where the LineHandler returned false.
+        uint64_t wall_ns = 0;      // Wall clock time taken by Run().
+    };
+
+    CppATReplay() = default;
+    ~CppATReplay();
+    CppATReplay(const CppATReplay &) = delete;
+    CppATReplay &operator=(const CppATReplay &) = delete;
+
+    /**
+     * @brief Memory maps a capture file for reading.
+     * @param[in] path Path to the capture.
+     * @retval True if the capture was mapped successfully, false otherwise.
+     */
+    bool Open(const char *path);
+
+    /**
+     * @brief Uses an in-memory capture instead of a file. The buffer must outlive the CppATReplay object.
+     * @param[in] capture Captured AT traffic.
+     */
+    void SetCapture(std::string_view capture);
+
+    /**
+     * @brief Splits the capture into chunks that start and end on line boundaries.
+     * @param[in] num_chunks Desired number of chunks. Fewer chunks are returned for short captures.
+     * @retval Chunks covering the whole capture, in order.
+     */
+    std::vector<std::string_view> SplitChunks(uint16_t num_chunks) const;
+
+    /**
+     * @brief Replays every AT command line in the capture.
+     * @param[in] factory Creates a LineHandler per worker (kPerChunk) or a single LineHandler (kOrdered). May be
+     * nullptr to only tokenize the capture and count commands.
+     * @param[in] num_threads Number of worker threads. 0 uses the number of hardware threads.
+     * @param[in] mode Dispatch mode.
+     * @retval Summary of the run. Per-command statistics are available from GetCommandStats().
+     */
+    Summary_t Run(const LineHandlerFactory &factory, uint16_t num_threads = 0, Mode mode = Mode::kPerChunk);
+
+    /**
+     * @brief Returns per-command statistics from the last Run(), sorted by command text.
+     */
+    const std::vector<CommandStats_t> &GetCommandStats() const { return command_stats_; }
+
+    /**
+     * @brief Extracts the command text from a line, e.g. "+CFG" from "AT+CFG=1,2". The line must start with the AT
+     * prefix, after optional spaces or tabs.
+     * @param[in] line Line to inspect.
+     * @param[out] command Command text.
+     * @retval True if the line contains an AT command, false otherwise.
+     */
+    static bool GetLineCommand(std::string_view line, std::string_view &command);
+
+private:
+    void Unmap();
+
+    std::string_view capture_;
+    void *mapping_ = nullptr;
+    size_t mapping_len_ = 0;
+    std::vector<CommandStats_t> command_stats_;
+};
+
+#endif /* _CPP_AT_REPLAY_HH_ */
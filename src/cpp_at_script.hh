@@ -0,0 +1,336 @@
+#ifndef _CPP_AT_SCRIPT_HH_
+#define _CPP_AT_SCRIPT_HH_
+
+#include <algorithm> // for std::copy
+#include <array>
+#include <cstring> // for memcpy, memmove
+#include <span>
+#include <string_view>
+#include "cpp_at_settings.hh"
+#include "stdint.h"
+
+/**
+ * @brief Named command scripts kept in compiled form. Each step of a script holds the index of its command, its op and
+ * its arguments already split and null terminated, so running a script calls the command callbacks directly without
+ * looking for prefixes, matching names or splitting arguments. Everything is stored in fixed size tables inside the
+ * object, so the store never allocates. Header only, so the parser can use it without linking another file.
+ *
+ * Attach a store to a parser with SetScriptStore() to enable the AT+SCRIPT (store) and AT+RUN (run) commands. Steps
+ * refer to commands by index, so a store belongs to a single parser.
+ */
+class CppATScriptStore
+{
+public:
+    static constexpr uint16_t kMaxNumScripts = CPP_AT_SCRIPT_MAX_NUM_SCRIPTS;
+    static constexpr uint16_t kNameMaxLen = CPP_AT_SCRIPT_NAME_MAX_LEN;
+    static constexpr uint16_t kMaxNumSteps = CPP_AT_SCRIPT_MAX_NUM_STEPS;
+    static constexpr uint16_t kMaxNumArgs = CPP_AT_SCRIPT_MAX_NUM_ARGS;
+    static constexpr size_t kTextLen = CPP_AT_SCRIPT_TEXT_LEN;
+
+    /**
+     * One compiled command call.
+     */
+    struct Step_t
+    {
+        uint16_t command_index = 0;   // Index of the command, as returned by GetATCommandIndex().
+        char op = '\0';               // Operator character, e.g. '=' or '?'.
+        bool ignore_failure = false;  // Keep running the script if the command fails.
+        uint16_t first_arg = 0;       // Index of the first split argument, see GetArgs().
+        uint16_t num_args = 0;        // Number of split arguments.
+        std::string_view args_string; // Unsplit argument text, null terminated.
+    };
+
+    CppATScriptStore() = default;
+
+    // Steps hold views into the store.
+    CppATScriptStore(const CppATScriptStore &) = delete;
+    CppATScriptStore &operator=(const CppATScriptStore &) = delete;
+
+    /**
+     * @brief Starts compiling a script. Steps are added with AddStep() and the script is stored by CommitScript().
+     * @param[in] name Name of the script.
+     * @retval True if successful, false if the name is blank or too long, or there is no room for another script.
+     */
+    bool BeginScript(std::string_view name);
+
+    /**
+     * @brief Adds a step to the script being compiled. The argument text is copied into the store.
+     * @param[in] step Command index, op and ignore_failure of the step. The other fields are filled in by the store.
+     * @param[in] args_string Unsplit argument text.
+     * @param[in] args Split arguments, may be empty for commands that split their own arguments.
+     * @retval True if successful, false if there is no script being compiled or no room for the step.
+     */
+    bool AddStep(Step_t step, std::string_view args_string, std::span<const std::string_view> args);
+
+    /**
+     * @brief Stores the script being compiled, replacing a script with the same name.
+     * @retval True if successful, false if there is no script being compiled or it has no steps.
+     */
+    bool CommitScript();
+
+    /**
+     * @brief Drops the script being compiled and the steps added to it.
+     */
+    void AbortScript();
+
+    /**
+     * @brief Removes a script.
+     * @param[in] name Name of the script.
+     * @retval True if the script was removed, false if there is no script with that name.
+     */
+    bool RemoveScript(std::string_view name);
+
+    /**
+     * @brief Removes all scripts.
+     */
+    void Clear();
+
+    /**
+     * @brief Returns the steps of a script.
+     * @param[in] name Name of the script.
+     * @retval Steps of the script, or an empty span if there is no script with that name.
+     */
+    std::span<const Step_t> GetScript(std::string_view name) const;
+
+    /**
+     * @brief Returns the split arguments of a step, each one null terminated.
+     */
+    const std::string_view *GetArgs(const Step_t &step) const { return args_.data() + step.first_arg; }
+
+    /**
+     * @brief Returns the number of stored scripts.
+     */
+    uint16_t GetNumScripts() const { return num_scripts_; }
+
+    /**
+     * @brief Returns the name of a stored script.
+     * @param[in] index Index of the script, 0 to GetNumScripts() - 1.
+     */
+    std::string_view GetScriptName(uint16_t index) const
+    {
+        return std::string_view(scripts_[index].name_buf, scripts_[index].name_len);
+    }
+
+    /**
+     * @brief Returns the number of steps of a stored script.
+     * @param[in] index Index of the script, 0 to GetNumScripts() - 1.
+     */
+    uint16_t GetNumSteps(uint16_t index) const { return scripts_[index].num_steps; }
+
+private:
+    struct Script_t
+    {
+        char name_buf[kNameMaxLen] = {};
+        uint16_t name_len = 0;
+        // Scripts own contiguous ranges of steps_, args_ and text_, in the same order as scripts_.
+        uint16_t first_step = 0;
+        uint16_t num_steps = 0;
+        uint16_t first_arg = 0;
+        uint16_t num_args = 0;
+        size_t text_start = 0;
+        size_t text_len = 0;
+    };
+
+    int32_t FindScript(std::string_view name) const;
+    void RemoveScriptAt(uint16_t index);
+    char *CopyText(std::string_view text);
+
+    std::array<Script_t, kMaxNumScripts> scripts_;
+    uint16_t num_scripts_ = 0;
+    std::array<Step_t, kMaxNumSteps> steps_;
+    std::array<std::string_view, kMaxNumArgs> args_;
+    std::array<char, kTextLen> text_;
+    // Script being compiled, its steps, arguments and text follow those of the stored scripts.
+    Script_t pending_;
+    bool is_pending_ = false;
+    // Used entries of steps_ and args_ and used bytes of text_, including those of the script being compiled.
+    uint16_t num_steps_ = 0;
+    uint16_t num_args_ = 0;
+    size_t text_len_ = 0;
+};
+
+/**
+ * CppATScriptStore Public Functions
+ */
+
+inline bool CppATScriptStore::BeginScript(std::string_view name)
+{
+    AbortScript();
+    if (name.empty() || name.length() > kNameMaxLen || (FindScript(name) < 0 && num_scripts_ == kMaxNumScripts))
+    {
+        return false;
+    }
+    pending_ = Script_t();
+    memcpy(pending_.name_buf, name.data(), name.length());
+    pending_.name_len = name.length();
+    pending_.first_step = num_steps_;
+    pending_.first_arg = num_args_;
+    pending_.text_start = text_len_;
+    is_pending_ = true;
+    return true;
+}
+
+inline bool CppATScriptStore::AddStep(Step_t step, std::string_view args_string, std::span<const std::string_view> args)
+{
+    if (!is_pending_)
+    {
+        return false;
+    }
+    size_t text_len = args_string.length() + 1;
+    for (std::string_view arg : args)
+    {
+        text_len += arg.length() + 1;
+    }
+    if (num_steps_ == kMaxNumSteps || args.size() > static_cast<size_t>(kMaxNumArgs - num_args_) ||
+        text_len > kTextLen - text_len_)
+    {
+        return false;
+    }
+    step.first_arg = num_args_;
+    step.num_args = args.size();
+    step.args_string = std::string_view(CopyText(args_string), args_string.length());
+    for (std::string_view arg : args)
+    {
+        args_[num_args_++] = std::string_view(CopyText(arg), arg.length());
+    }
+    steps_[num_steps_++] = step;
+    pending_.num_steps++;
+    pending_.num_args += args.size();
+    pending_.text_len += text_len;
+    return true;
+}
+
+inline bool CppATScriptStore::CommitScript()
+{
+    if (!is_pending_ || pending_.num_steps == 0)
+    {
+        AbortScript();
+        return false;
+    }
+    int32_t index = FindScript(std::string_view(pending_.name_buf, pending_.name_len));
+    if (index >= 0)
+    {
+        RemoveScriptAt(index); // Moves the new script into the space of the old one if it came after it.
+    }
+    scripts_[num_scripts_++] = pending_;
+    is_pending_ = false;
+    return true;
+}
+
+inline void CppATScriptStore::AbortScript()
+{
+    if (!is_pending_)
+    {
+        return;
+    }
+    num_steps_ = pending_.first_step;
+    num_args_ = pending_.first_arg;
+    text_len_ = pending_.text_start;
+    is_pending_ = false;
+}
+
+inline bool CppATScriptStore::RemoveScript(std::string_view name)
+{
+    int32_t index = FindScript(name);
+    if (index < 0)
+    {
+        return false;
+    }
+    RemoveScriptAt(index);
+    return true;
+}
+
+inline void CppATScriptStore::Clear()
+{
+    num_scripts_ = 0;
+    num_steps_ = 0;
+    num_args_ = 0;
+    text_len_ = 0;
+    is_pending_ = false;
+}
+
+inline std::span<const CppATScriptStore::Step_t> CppATScriptStore::GetScript(std::string_view name) const
+{
+    int32_t index = FindScript(name);
+    if (index < 0)
+    {
+        return {};
+    }
+    return std::span<const Step_t>(steps_.data() + scripts_[index].first_step, scripts_[index].num_steps);
+}
+
+/**
+ * CppATScriptStore Private Functions
+ */
+
+inline int32_t CppATScriptStore::FindScript(std::string_view name) const
+{
+    for (uint16_t i = 0; i < num_scripts_; i++)
+    {
+        if (name == GetScriptName(i))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+inline void CppATScriptStore::RemoveScriptAt(uint16_t index)
+{
+    // Close the gap by moving everything after the script down, then point the moved views at the moved text.
+    const Script_t removed = scripts_[index];
+    auto rebase = [&removed](std::string_view view)
+    { return std::string_view(view.data() - removed.text_len, view.length()); };
+
+    std::copy(steps_.begin() + removed.first_step + removed.num_steps, steps_.begin() + num_steps_,
+              steps_.begin() + removed.first_step);
+    num_steps_ -= removed.num_steps;
+    for (uint16_t i = removed.first_step; i < num_steps_; i++)
+    {
+        steps_[i].first_arg -= removed.num_args;
+        steps_[i].args_string = rebase(steps_[i].args_string);
+    }
+
+    std::copy(args_.begin() + removed.first_arg + removed.num_args, args_.begin() + num_args_,
+              args_.begin() + removed.first_arg);
+    num_args_ -= removed.num_args;
+    for (uint16_t i = removed.first_arg; i < num_args_; i++)
+    {
+        args_[i] = rebase(args_[i]);
+    }
+
+    size_t text_end = removed.text_start + removed.text_len;
+    memmove(text_.data() + removed.text_start, text_.data() + text_end, text_len_ - text_end);
+    text_len_ -= removed.text_len;
+
+    auto shift = [&removed](Script_t &script)
+    {
+        script.first_step -= removed.num_steps;
+        script.first_arg -= removed.num_args;
+        script.text_start -= removed.text_len;
+    };
+    for (uint16_t i = index + 1; i < num_scripts_; i++)
+    {
+        scripts_[i - 1] = scripts_[i];
+        shift(scripts_[i - 1]);
+    }
+    num_scripts_--;
+    if (is_pending_)
+    {
+        shift(pending_);
+    }
+}
+
+inline char *CppATScriptStore::CopyText(std::string_view text)
+{
+    char *dest = text_.data() + text_len_;
+    if (!text.empty())
+    {
+        memcpy(dest, text.data(), text.length());
+    }
+    dest[text.length()] = '\0';
+    text_len_ += text.length() + 1;
+    return dest;
+}
+
+#endif /* _CPP_AT_SCRIPT_HH_ */
@@ -0,0 +1,114 @@
+#include "cpp_at_trace.hh"
+
+#include <cinttypes> // for PRIu64
+#include <cstdio>    // for snprintf
+
+/**
+ * CppATTraceDecoder Public Functions
+ */
+
+bool CppATTraceDecoder::Load(std::string_view dump)
+{
+    commands_.clear();
+    records_.clear();
+
+    size_t pos = 0;
+    auto read = [&dump, &pos](void *dst, size_t len)
+    {
+        if (pos + len > dump.length())
+        {
+            return false;
+        }
+        memcpy(dst, dump.data() + pos, len);
+        pos += len;
+        return true;
+    };
+
+    uint8_t header[8];
+    if (!read(header, sizeof(header)) || memcmp(header, kCppATTraceMagic, 4) != 0 ||
+        header[4] != kCppATTraceVersion || header[5] != sizeof(CppATTraceBuffer::Record_t))
+    {
+        return false;
+    }
+    uint16_t num_commands;
+    memcpy(&num_commands, &header[6], sizeof(num_commands));
+    for (uint16_t i = 0; i < num_commands; i++)
+    {
+        uint8_t len;
+        char command[UINT8_MAX];
+        if (!read(&len, 1) || !read(command, len))
+        {
+            return false;
+        }
+        commands_.emplace_back(command, len);
+    }
+
+    uint32_t num_records;
+    if (!read(&num_records, sizeof(num_records)) ||
+        dump.length() - pos < static_cast<uint64_t>(num_records) * sizeof(CppATTraceBuffer::Record_t))
+    {
+        return false;
+    }
+    records_.resize(num_records);
+    for (CppATTraceBuffer::Record_t &record : records_)
+    {
+        read(&record, sizeof(record));
+    }
+    return true;
+}
+
+std::string_view CppATTraceDecoder::GetCommand(uint16_t command_index) const
+{
+    if (command_index >= commands_.size())
+    {
+        return "";
+    }
+    return commands_[command_index];
+}
+
+std::string CppATTraceDecoder::FormatRecord(uint32_t index) const
+{
+    const CppATTraceBuffer::Record_t &record = records_[index];
+    if (record.result == CppATTraceBuffer::Result::kDropped)
+    {
+        return "[dropped]";
+    }
+
+    char timestamp[32];
+    snprintf(timestamp, sizeof(timestamp), "[%" PRIu64 ".%09" PRIu64 "] ", record.timestamp_ns / 1000000000u,
+             record.timestamp_ns % 1000000000u);
+    std::string line = timestamp;
+    std::string_view prefix(record.args_prefix, record.args_prefix_len);
+    if (record.command_index == CppATTraceBuffer::kCommandIndexNone)
+    {
+        // Prefix holds the command text that failed to match.
+        line += "AT";
+        line += prefix;
+        line += record.args_len > record.args_prefix_len ? "..." : "";
+    }
+    else
+    {
+        line += "AT";
+        line += GetCommand(record.command_index);
+        if (record.op != '\0')
+        {
+            line += record.op;
+        }
+        line += prefix;
+        if (record.args_len > record.args_prefix_len)
+        {
+            char suffix[48];
+            snprintf(suffix, sizeof(suffix), "...(%u chars, hash %08" PRIx32 ")", record.args_len, record.args_hash);
+            line += suffix;
+        }
+    }
+
+    static const char *const kResultStrings[] = {"OK", "ERROR", "UNKNOWN COMMAND", "BAD ARGS"};
+    uint8_t result = static_cast<uint8_t>(record.result);
+    char result_str[64];
+    snprintf(result_str, sizeof(result_str), " -> %s (%u.%03u us)",
+             result < sizeof(kResultStrings) / sizeof(kResultStrings[0]) ? kResultStrings[result] : "?",
+             record.duration_ns / 1000, record.duration_ns % 1000);
+    line += result_str;
+    return line;
+}
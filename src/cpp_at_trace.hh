@@ -0,0 +1,283 @@
+#ifndef _CPP_AT_TRACE_HH_
+#define _CPP_AT_TRACE_HH_
+
+#include <atomic>
+#include <chrono>
+#include <cstring> // for memcpy
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cpp_at_function.hh"
+#include "stdint.h"
+
+/**
+ * @brief Flight recorder for parsed AT commands. Fixed size, lock-free ring buffer of compact binary records that can
+ * be written from any number of parsers and threads at once. The oldest records are overwritten when it fills up.
+ */
+class CppATTraceBuffer
+{
+public:
+    static constexpr uint16_t kCommandIndexNone = 0xFFFF; // Command index used when no command was matched.
+    static constexpr uint16_t kArgsPrefixLen = 16;        // Number of argument characters kept in each record.
+
+    enum class Result : uint8_t
+    {
+        kOK = 0,             // Callback returned true.
+        kError = 1,          // Callback returned false.
+        kUnknownCommand = 2, // Command couldn't be matched to an ATCommandDef_t.
+        kBadArgs = 3,        // Too many, too few or too long arguments.
+        kDropped = 4         // Record was overwritten while it was being read. Only appears in dumps.
+    };
+
+    struct Record_t
+    {
+        uint64_t timestamp_ns = 0;          // Time when the callback was called.
+        uint32_t duration_ns = 0;           // Time spent in the callback, saturated at UINT32_MAX.
+        uint32_t args_hash = 0;             // FNV-1a hash of the full argument string.
+        uint16_t command_index = 0;         // Index of the command in the parser, or kCommandIndexNone.
+        uint16_t args_len = 0;              // Length of the full argument string.
+        char op = '\0';                     // Operator character, e.g. '=' or '?'.
+        uint8_t num_args = 0;               // Number of arguments, saturated at UINT8_MAX.
+        Result result = Result::kOK;        // Outcome of the command.
+        uint8_t args_prefix_len = 0;        // Number of valid characters in args_prefix.
+        char args_prefix[kArgsPrefixLen]{}; // First characters of the argument string (or of the unmatched command).
+    };
+
+    using Clock = uint64_t (*)(void);
+
+    /**
+     * @brief Sets the function used to timestamp records. Defaults to std::chrono::steady_clock.
+     * @param[in] clock Function returning a monotonic time in nanoseconds.
+     */
+    void SetClock(Clock clock) { clock_ = clock; }
+
+    /**
+     * @brief Returns the current time from the trace clock, in nanoseconds.
+     */
+    uint64_t Now() const { return clock_(); }
+
+    /**
+     * @brief Appends a record to the ring buffer. Lock-free and safe to call from multiple threads. If the slot is
+     * still being written by a writer from a full lap of the ring earlier, the record is dropped instead of waiting and
+     * reads as Result::kDropped.
+     * @param[in] command_index Index of the command in the parser, or kCommandIndexNone.
+     * @param[in] op Operator character.
+     * @param[in] num_args Number of arguments.
+     * @param[in] args Full argument string (or the unmatched command text if command_index is kCommandIndexNone).
+     * @param[in] result Outcome of the command.
+     * @param[in] timestamp_ns Time when the callback was called.
+     * @param[in] duration_ns Time spent in the callback.
+     */
+    void Record(uint16_t command_index, char op, uint16_t num_args, std::string_view args, Result result,
+                uint64_t timestamp_ns, uint64_t duration_ns)
+    {
+        uint64_t position = head_.fetch_add(1, std::memory_order_relaxed);
+        Slot_t &slot = slots_[position & capacity_mask_];
+        // Seqlock: odd sequence while writing, even sequence that encodes the position when done. Only one writer
+        // may own a slot, so claim it with a CAS from an older, finished sequence. A writer that finds the slot in use
+        // (odd) or already taken by a newer position gives up, rather than writing over a record that is in progress.
+        uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+        do
+        {
+            if ((seq & 1) != 0 || seq > 2 * position)
+            {
+                return;
+            }
+        } while (!slot.seq.compare_exchange_weak(seq, 2 * position + 1, std::memory_order_relaxed));
+        std::atomic_thread_fence(std::memory_order_release);
+
+        Record_t &record = slot.record;
+        record.timestamp_ns = timestamp_ns;
+        record.duration_ns = duration_ns > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(duration_ns);
+        record.args_hash = Hash(args);
+        record.command_index = command_index;
+        record.args_len = args.length() > UINT16_MAX ? UINT16_MAX : static_cast<uint16_t>(args.length());
+        record.op = op;
+        record.num_args = num_args > UINT8_MAX ? UINT8_MAX : static_cast<uint8_t>(num_args);
+        record.result = result;
+        record.args_prefix_len = args.length() > kArgsPrefixLen ? kArgsPrefixLen : static_cast<uint8_t>(args.length());
+        memcpy(record.args_prefix, args.data(), record.args_prefix_len);
+
+        slot.seq.store(2 * position + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copies out the record written at a given position.
+     * @param[in] position Position of the record, in the range [GetTail(), GetHead()).
+     * @param[out] record Copy of the record.
+     * @retval True if the record was read, false if it was being written or has been overwritten.
+     */
+    bool ReadRecord(uint64_t position, Record_t &record) const
+    {
+        const Slot_t &slot = slots_[position & capacity_mask_];
+        uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != 2 * position + 2)
+        {
+            return false;
+        }
+        memcpy(static_cast<void *>(&record), &slot.record, sizeof(Record_t));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.seq.load(std::memory_order_relaxed) == seq;
+    }
+
+    /**
+     * @brief Returns the position after the newest record.
+     */
+    uint64_t GetHead() const { return head_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Returns the position of the oldest record that hasn't been overwritten.
+     */
+    uint64_t GetTail() const
+    {
+        uint64_t head = GetHead();
+        return head > capacity_ ? head - capacity_ : 0;
+    }
+
+    uint32_t GetCapacity() const { return capacity_; }
+
+    /**
+     * @brief 32 bit FNV-1a hash used for argument strings.
+     */
+    static uint32_t Hash(std::string_view text)
+    {
+        uint32_t hash = 2166136261u;
+        for (char c : text)
+        {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+        return hash;
+    }
+
+protected:
+    struct Slot_t
+    {
+        std::atomic<uint64_t> seq = 0;
+        Record_t record;
+    };
+
+    CppATTraceBuffer(Slot_t *slots, uint32_t capacity)
+        : slots_(slots), capacity_(capacity), capacity_mask_(capacity - 1)
+    {
+    }
+
+private:
+    static uint64_t SteadyClockNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    Slot_t *slots_;
+    uint32_t capacity_;
+    uint64_t capacity_mask_;
+    std::atomic<uint64_t> head_ = 0;
+    Clock clock_ = SteadyClockNs;
+};
+
+/**
+ * @brief CppATTraceBuffer with storage for kCapacity records.
+ * @tparam kCapacity Number of records to keep. Must be a power of two.
+ */
+template <uint32_t kCapacity>
+class CppATTraceRingBuffer : public CppATTraceBuffer
+{
+public:
+    static_assert(kCapacity > 0 && (kCapacity & (kCapacity - 1)) == 0, "Trace capacity must be a power of two.");
+
+    CppATTraceRingBuffer() : CppATTraceBuffer(slots_, kCapacity) {}
+    CppATTraceRingBuffer(const CppATTraceRingBuffer &) = delete;
+    CppATTraceRingBuffer &operator=(const CppATTraceRingBuffer &) = delete;
+
+private:
+    Slot_t slots_[kCapacity];
+};
+
+/**
+ * Binary dump format, in host byte order:
+ *  char magic[4] = "CATR", uint8_t version, uint8_t record_size, uint16_t num_commands,
+ *  num_commands x {uint8_t len, char text[len]}, uint32_t num_records, num_records x Record_t.
+ */
+static constexpr char kCppATTraceMagic[4] = {'C', 'A', 'T', 'R'};
+static constexpr uint8_t kCppATTraceVersion = 1;
+
+/**
+ * @brief Writes a binary dump of a trace buffer, including the command names of a parser so that the dump can be
+ * decoded without the firmware.
+ * @param[in] parser Parser whose command indices were recorded.
+ * @param[in] trace Trace buffer to dump.
+ * @param[in] write Function called with consecutive pieces of the dump, e.g. to write them to a UART or a file.
+ * @retval Number of records in the dump.
+ */
+template <typename Parser>
+uint32_t CppATTraceDump(Parser &parser, const CppATTraceBuffer &trace,
+                        const CppATFunction<void(const uint8_t *, size_t)> &write)
+{
+    uint8_t header[8];
+    memcpy(header, kCppATTraceMagic, 4);
+    header[4] = kCppATTraceVersion;
+    header[5] = sizeof(CppATTraceBuffer::Record_t);
+    uint16_t num_commands = parser.GetNumATCommands();
+    memcpy(&header[6], &num_commands, sizeof(num_commands));
+    write(header, sizeof(header));
+    for (uint16_t i = 0; i < num_commands; i++)
+    {
+        std::string_view command = parser.GetATCommand(i)->command;
+        uint8_t len = command.length() > UINT8_MAX ? UINT8_MAX : command.length();
+        write(&len, 1);
+        write(reinterpret_cast<const uint8_t *>(command.data()), len);
+    }
+
+    uint64_t tail = trace.GetTail();
+    uint64_t head = trace.GetHead();
+    uint32_t num_records = head - tail;
+    write(reinterpret_cast<const uint8_t *>(&num_records), sizeof(num_records));
+    for (uint64_t position = tail; position < head; position++)
+    {
+        CppATTraceBuffer::Record_t record;
+        if (!trace.ReadRecord(position, record))
+        {
+            record = CppATTraceBuffer::Record_t();
+            record.result = CppATTraceBuffer::Result::kDropped;
+        }
+        write(reinterpret_cast<const uint8_t *>(&record), sizeof(record));
+    }
+    return num_records;
+}
+
+/**
+ * @brief Turns a binary trace dump back into readable AT command lines.
+ */
+class CppATTraceDecoder
+{
+public:
+    /**
+     * @brief Loads a dump written by CppATTraceDump.
+     * @param[in] dump Dump contents.
+     * @retval True if the dump was valid, false otherwise.
+     */
+    bool Load(std::string_view dump);
+
+    uint32_t GetNumRecords() const { return records_.size(); }
+    const CppATTraceBuffer::Record_t &GetRecord(uint32_t index) const { return records_[index]; }
+
+    /**
+     * @brief Returns the command text for a command index, e.g. "+CFG".
+     */
+    std::string_view GetCommand(uint16_t command_index) const;
+
+    /**
+     * @brief Formats a record as a line like "[12.000345678] AT+CFG=1,2 -> OK (1.250 us)". Arguments that were
+     * longer than the stored prefix are followed by "..." and their length and hash.
+     * @param[in] index Index of the record.
+     * @retval Formatted line, without a line ending.
+     */
+    std::string FormatRecord(uint32_t index) const;
+
+private:
+    std::vector<std::string> commands_;
+    std::vector<CppATTraceBuffer::Record_t> records_;
+};
+
+#endif /* _CPP_AT_TRACE_HH_ */
@@ -0,0 +1,48 @@
+// libFuzzer target for CppAT::ParseMessage. Build with clang from the repository root, e.g.
+//   clang++ -std=c++20 -g -O1 -fsanitize=fuzzer,address,undefined -Isrc -Isettings
+//       src/cpp_at.cc src/cpp_at_codec.cc test/fuzz/fuzz_parse_message.cc -o fuzz_parse_message
+// and run it on the seed corpus with
+//   ./fuzz_parse_message -max_total_time=60 test/fuzz/corpus
+
+#include "cpp_at.hh"
+
+#include <cstdint>
+
+int CppAT::cpp_at_printf(const char *, ...) { return 0; }
+
+CPP_AT_CALLBACK(FuzzCallback)
+{
+    uint32_t number;
+    for (uint16_t i = 0; i < num_args; i++)
+    {
+        CppAT::ArgToNum(args[i], number);
+    }
+    CPP_AT_SUCCESS();
+}
+
+CPP_AT_RAW_CALLBACK(FuzzRawCallback)
+{
+    for (std::string_view arg; args.Next(arg);)
+    {
+        uint8_t bytes[16];
+        size_t num_bytes;
+        CppAT::HexArgToBytes(arg, bytes, num_bytes);
+    }
+    CPP_AT_SILENT_SUCCESS();
+}
+
+static CppAT::ATCommandDef_t fuzz_command_list[] = {
+    {.command = "+A", .min_args = 0, .max_args = 0, .callback = FuzzCallback},
+    {.command = "+B", .min_args = 1, .max_args = 3, .callback = FuzzCallback},
+    {.command = "+C", .min_args = 0, .max_args = CppAT::kMaxNumArgs, .callback = FuzzCallback},
+    {.command = "+R", .raw_callback = FuzzRawCallback}};
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static CppAT parser = CppAT(fuzz_command_list, sizeof(fuzz_command_list) / sizeof(fuzz_command_list[0]));
+    char buf[256];
+    CppATOutputBuffer output(buf, sizeof(buf));
+    CppATOutputBuffer::Scope scope(output);
+    parser.ParseMessage(std::string_view(reinterpret_cast<const char *>(data), size));
+    return 0;
+}
@@ -0,0 +1,161 @@
+// Tests for the heap-free build profile. They replace the allocation functions and need CPP_AT_HEAP_FREE=1 in every
+// source, so they are built as their own binary instead of being part of the main tests. From the repository root:
+//   g++ -std=c++20 -Isrc -Isettings -DCPP_AT_HEAP_FREE=1 -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+//       src/cpp_at.cc test/no_heap/test_cpp_at_no_heap.cc -lgtest -lgtest_main -pthread -o test_cpp_at_no_heap
+
+#include "gtest/gtest.h"
+#include "cpp_at.hh"
+
+#include <atomic>
+#include <cstdlib> // for malloc, free
+#include <memory_resource>
+#include <new>
+
+#if !CPP_AT_HEAP_FREE
+#error "Build the heap-free tests with -DCPP_AT_HEAP_FREE=1."
+#endif
+
+int CppAT::cpp_at_printf(const char *, ...) { return 0; } // Keep stdio from allocating its buffers mid test.
+
+// Count calls to the malloc family through the linker's --wrap, and to operator new, which libstdc++ implements
+// without going through the wrapped symbols. Kept out of line so the compiler can't pair or elide the calls.
+static std::atomic<uint32_t> num_allocations = 0;
+
+extern "C"
+{
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t num, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+[[gnu::noinline]] void *__wrap_malloc(size_t size)
+{
+    num_allocations++;
+    return __real_malloc(size);
+}
+
+[[gnu::noinline]] void *__wrap_calloc(size_t num, size_t size)
+{
+    num_allocations++;
+    return __real_calloc(num, size);
+}
+
+[[gnu::noinline]] void *__wrap_realloc(void *ptr, size_t size)
+{
+    num_allocations++;
+    return __real_realloc(ptr, size);
+}
+}
+
+[[gnu::noinline]] void *operator new(std::size_t size)
+{
+    num_allocations++;
+    void *ptr = __real_malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+[[gnu::noinline]] void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { operator delete(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { operator delete(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { operator delete(ptr); }
+
+TEST(CppATNoHeap, AllocationsAreCounted)
+{
+    // The tests below only mean something if every kind of allocation is counted.
+    num_allocations = 0;
+    void *volatile ptr = malloc(16);
+    free(ptr);
+    ptr = calloc(1, 16);
+    ptr = realloc(ptr, 32);
+    free(ptr);
+    delete new int(1);
+    EXPECT_EQ(num_allocations, 4u);
+}
+
+static uint16_t no_heap_callback_num_args = 0;
+CPP_AT_CALLBACK(NoHeapCallback)
+{
+    no_heap_callback_num_args = num_args;
+    return true;
+}
+
+class NoHeapHandler
+{
+public:
+    CPP_AT_CALLBACK(MemberCallback)
+    {
+        num_calls++;
+        return true;
+    }
+    uint16_t num_calls = 0;
+};
+
+static const CppAT::ATCommandDef_t no_heap_at_command_list[] = {
+    {.command_buf = "+NOHEAP",
+     .min_args = 0,
+     .max_args = 5,
+     .help_string_buf = "Callback that must not allocate.",
+     .callback = NoHeapCallback}};
+
+TEST(CppATNoHeap, StaticCommandListDoesNotAllocate)
+{
+    num_allocations = 0;
+    CppAT parser = CppAT(no_heap_at_command_list, 1, true);
+    ASSERT_TRUE(parser.is_valid);
+    ASSERT_TRUE(parser.ParseMessage("AT+NOHEAP=1,2,3\r\n"));
+    ASSERT_TRUE(parser.ParseMessage("AT+NOHEAP?\r\nAT+NOHEAP=a\r\n"));
+    ASSERT_TRUE(parser.ParseMessage("AT+HELP\r\n"));
+    ASSERT_FALSE(parser.ParseMessage("AT+MISSING\r\n"));
+    EXPECT_EQ(no_heap_callback_num_args, 1);
+    EXPECT_EQ(num_allocations, 0u);
+}
+
+TEST(CppATNoHeap, BoundMemberCallbackDoesNotAllocate)
+{
+    NoHeapHandler handler;
+    num_allocations = 0;
+    CppAT::ATCommandDef_t def = {
+        .command_buf = "+MEMBER",
+        .callback = CPP_AT_BIND_MEMBER_CALLBACK(NoHeapHandler::MemberCallback, handler)};
+    CppAT parser = CppAT(&def, 1, true);
+    ASSERT_TRUE(parser.ParseMessage("AT+MEMBER\r\n"));
+    EXPECT_EQ(handler.num_calls, 1);
+    EXPECT_EQ(num_allocations, 0u);
+}
+
+TEST(CppATNoHeap, CopiedCommandListFromMemoryResourceDoesNotAllocate)
+{
+    alignas(std::max_align_t) char arena_buf[1024];
+    std::pmr::monotonic_buffer_resource arena(arena_buf, sizeof(arena_buf), std::pmr::null_memory_resource());
+    num_allocations = 0;
+    CppAT::ATCommandDef_t at_command_list[] = {{.command = "+ARENA", .max_args = 2, .callback = NoHeapCallback}};
+    CppAT parser = CppAT(at_command_list, 1, false, &arena);
+    ASSERT_TRUE(parser.is_valid);
+    CppAT moved(std::move(parser));
+    ASSERT_TRUE(moved.ParseMessage("AT+ARENA=1,2\r\n"));
+    EXPECT_EQ(no_heap_callback_num_args, 2);
+    EXPECT_EQ(num_allocations, 0u);
+}
+
+TEST(CppATNoHeap, CopiedCommandListDoesNotAllocate)
+{
+    num_allocations = 0;
+    CppAT::ATCommandDef_t at_command_list[] = {
+        {.command = "+COPIED", .max_args = 2, .help_string = "Copied into the parser.", .callback = NoHeapCallback}};
+    CppAT parser = CppAT(at_command_list, 1);
+    ASSERT_TRUE(parser.is_valid);
+    ASSERT_TRUE(parser.ParseMessage("AT+COPIED=1,2\r\n"));
+    EXPECT_EQ(no_heap_callback_num_args, 2);
+    EXPECT_EQ(num_allocations, 0u);
+}
+
+TEST(CppATNoHeap, RejectTooManyCommands)
+{
+    CppAT::ATCommandDef_t at_command_list[CPP_AT_MAX_NUM_COMMANDS + 1];
+    CppAT parser = CppAT(at_command_list, CPP_AT_MAX_NUM_COMMANDS + 1);
+    ASSERT_FALSE(parser.is_valid);
+}
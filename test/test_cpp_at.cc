@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 #include "cpp_at.hh"
+#include <memory_resource>
 #include <string_view>
+#include <vector>
 
 // For mapping cpp_at_printf
 #include <cstdarg>
@@ -405,6 +407,23 @@ TEST(CppAT, AllowBlankArgs)
     EXPECT_STREQ(stored_args[3].data(), "");
 }
 
+TEST(CppAT, ArgsStopAtLineEnd)
+{
+    CppAT parser = BuildStoreArgParser();
+
+    // A command without args doesn't pick up the next line as its args.
+    ASSERT_TRUE(parser.ParseMessage("AT+STORE\r\nAT+STORE=a,b\r\n"));
+    ASSERT_EQ(stored_args.size(), 2u);
+    parser.ParseMessage("AT+STORE=a,b\r\nAT+STORE\r\n");
+    ASSERT_EQ(stored_args.size(), 0u);
+
+    // "AT" inside args is part of the args, not another command.
+    ASSERT_TRUE(parser.ParseMessage("AT+STORE=CATS,ATAT+STORE\r\n"));
+    ASSERT_EQ(stored_args.size(), 2u);
+    EXPECT_EQ(stored_args[0], "CATS");
+    EXPECT_EQ(stored_args[1], "ATAT+STORE");
+}
+
 static constexpr float kFloatCloseEnough = 0.00001f;
 TEST(CppAT, ArgToNumFloat)
 {
@@ -482,6 +501,279 @@ TEST(CppAT, ArgToNumUint32_t)
     ASSERT_EQ(num, 0xDEADBEEF);
 }
 
+TEST(CppAT, ArgsToNumsString)
+{
+    // Whole argument string with more values than kMaxNumArgs, decoded in one pass.
+    std::string args_string;
+    for (int i = 0; i < 500; i++)
+    {
+        args_string += std::to_string(i * 7 - 1000) + (i < 499 ? "," : "");
+    }
+    int16_t values[500];
+    CppAT::ArgsToNumsResult_t result = CppAT::ArgsToNums(args_string, std::span(values));
+    ASSERT_EQ(result.num_values, 500u);
+    ASSERT_EQ(result.num_errors, 0u);
+    for (int i = 0; i < 500; i++)
+    {
+        ASSERT_EQ(values[i], i * 7 - 1000);
+    }
+
+    // Per-value errors.
+    uint8_t bytes[6];
+    CppAT::ArgError errors[6];
+    result = CppAT::ArgsToNums(" 1, +2 ,256,-1,x3,", std::span(bytes), std::span(errors));
+    ASSERT_EQ(result.num_values, 6u);
+    ASSERT_EQ(result.num_errors, 4u);
+    ASSERT_EQ(result.first_error_index, 2u);
+    EXPECT_EQ(bytes[0], 1);
+    EXPECT_EQ(bytes[1], 2);
+    EXPECT_EQ(errors[2], CppAT::ArgError::kOutOfRange);
+    EXPECT_EQ(errors[3], CppAT::ArgError::kOutOfRange);
+    EXPECT_EQ(errors[4], CppAT::ArgError::kInvalid);
+    EXPECT_EQ(errors[5], CppAT::ArgError::kBlank);
+
+    // Values that don't fit in the destination are counted but not stored.
+    uint32_t words[2];
+    result = CppAT::ArgsToNums("0xDEADBEEF,ff,10", std::span(words), {}, 16);
+    ASSERT_EQ(result.num_values, 3u);
+    ASSERT_EQ(result.num_errors, 0u);
+    EXPECT_EQ(words[0], 0xDEADBEEFu);
+    EXPECT_EQ(words[1], 0xFFu);
+
+    // Limits of signed types.
+    int8_t small[3];
+    CppAT::ArgsToNums("-128,127,-129", std::span(small), std::span(errors));
+    EXPECT_EQ(small[0], -128);
+    EXPECT_EQ(small[1], 127);
+    EXPECT_EQ(errors[2], CppAT::ArgError::kOutOfRange);
+    int64_t big[1];
+    ASSERT_EQ(CppAT::ArgsToNums("-9223372036854775808", std::span(big)).num_errors, 0u);
+    EXPECT_EQ(big[0], INT64_MIN);
+    ASSERT_EQ(CppAT::ArgsToNums("99999999999999999999", std::span(big)).num_errors, 1u);
+
+    // Floats.
+    float floats[4];
+    result = CppAT::ArgsToNums("1.5, -2e3,.25,7.1abc", std::span(floats), std::span(errors));
+    ASSERT_EQ(result.num_errors, 1u);
+    EXPECT_FLOAT_EQ(floats[0], 1.5f);
+    EXPECT_FLOAT_EQ(floats[1], -2000.0f);
+    EXPECT_FLOAT_EQ(floats[2], 0.25f);
+    EXPECT_EQ(errors[3], CppAT::ArgError::kInvalid);
+
+    ASSERT_EQ(CppAT::ArgsToNums("", std::span(floats)).num_values, 0u);
+}
+
+static float calibration[4];
+CPP_AT_CALLBACK(CalibrationCallback)
+{
+    uint16_t channel;
+    CPP_AT_TRY_ARG2NUM(0, channel);
+    CPP_AT_TRY_ARGS2NUMS(1, calibration);
+    return channel == 2;
+}
+
+TEST(CppAT, ArgsToNumsArgs)
+{
+    CppAT::ATCommandDef_t at_command_list[] = {{.command = "+CAL", .callback = CalibrationCallback}};
+    CppAT parser = CppAT(at_command_list, 1);
+    ASSERT_TRUE(parser.ParseMessage("AT+CAL=2,0.5,1.5,-2,8\r\n"));
+    EXPECT_FLOAT_EQ(calibration[0], 0.5f);
+    EXPECT_FLOAT_EQ(calibration[3], 8.0f);
+    ASSERT_FALSE(parser.ParseMessage("AT+CAL=2,0.5,1.5,-2\r\n"));    // Too few values.
+    ASSERT_FALSE(parser.ParseMessage("AT+CAL=2,0.5,1.5,-2,8,9\r\n")); // Too many values.
+    ASSERT_FALSE(parser.ParseMessage("AT+CAL=2,0.5,oops,-2,8\r\n"));  // Bad value.
+}
+
+static_assert(std::ranges::input_range<CppATArgs>);
+
+TEST(CppAT, LazyArgs)
+{
+    CppATArgs args("1,,abc,");
+    std::string_view arg;
+    ASSERT_TRUE(args.Next(arg));
+    ASSERT_EQ(arg, "1");
+    ASSERT_EQ(args.GetRemaining(), ",abc,");
+    ASSERT_TRUE(args.Next(arg));
+    ASSERT_EQ(arg, "");
+    ASSERT_TRUE(args.Next(arg));
+    ASSERT_EQ(arg, "abc");
+    ASSERT_TRUE(args.Next(arg)); // Trailing delimiter implies a blank argument.
+    ASSERT_EQ(arg, "");
+    ASSERT_FALSE(args.HasNext());
+    ASSERT_FALSE(args.Next(arg));
+
+    std::vector<std::string_view> collected;
+    for (std::string_view a : args) // Iteration always starts from the beginning.
+    {
+        collected.push_back(a);
+    }
+    ASSERT_EQ(collected, std::vector<std::string_view>({"1", "", "abc", ""}));
+    ASSERT_EQ(CppATArgs("").begin(), CppATArgs("").end());
+}
+
+static std::string first_raw_arg;
+static uint32_t raw_sum = 0;
+CPP_AT_RAW_CALLBACK(RawSumCallback)
+{
+    // AT+SUM=<name>,<v0>,<v1>,... with any number of values.
+    std::string_view name;
+    if (!args.Next(name))
+    {
+        CPP_AT_ERROR("Missing name.");
+    }
+    first_raw_arg = name;
+    raw_sum = 0;
+    for (std::string_view arg; args.Next(arg);)
+    {
+        uint32_t value;
+        if (CppAT::ParseArg(arg, value) != CppAT::ArgError::kNone)
+        {
+            CPP_AT_ERROR("Bad value.");
+        }
+        raw_sum += value;
+    }
+    CPP_AT_SILENT_SUCCESS();
+}
+
+TEST(CppAT, RawCallbackNoArgLimits)
+{
+    CppAT::ATCommandDef_t at_command_list[] = {{.command = "+SUM", .raw_callback = RawSumCallback}};
+    CppAT parser = CppAT(at_command_list, 1);
+
+    // Far more arguments than kMaxNumArgs, and a name longer than kArgMaxLen.
+    std::string long_name(CppAT::kArgMaxLen * 2, 'n');
+    std::string message = "AT+SUM=" + long_name;
+    for (uint32_t i = 1; i <= 1000; i++)
+    {
+        message += "," + std::to_string(i);
+    }
+    ASSERT_TRUE(parser.ParseMessage(message + "\r\n"));
+    ASSERT_EQ(first_raw_arg, long_name);
+    ASSERT_EQ(raw_sum, 500500u);
+
+    ASSERT_FALSE(parser.ParseMessage("AT+SUM=x,1,y\r\n"));
+    ASSERT_FALSE(parser.ParseMessage("AT+SUM\r\n"));
+}
+
+static std::vector<size_t> batch_sizes;
+static std::string batch_log; // Order of calls, "S<num_invocations>" for batches and "O" for AT+OTHER.
+static uint32_t registers[256];
+CPP_AT_BATCH_CALLBACK(SetRegistersCallback)
+{
+    // AT+SET=<addr>,<value>
+    batch_sizes.push_back(invocations.size());
+    batch_log += "S" + std::to_string(invocations.size());
+    for (size_t i = 0; i < invocations.size(); i++)
+    {
+        const CppATInvocation_t &invocation = invocations[i];
+        uint8_t addr;
+        uint32_t value;
+        results[i] = invocation.op == '=' && CppAT::ParseArg(invocation.args[0], addr) == CppAT::ArgError::kNone &&
+                     CppAT::ParseArg(invocation.args[1], value) == CppAT::ArgError::kNone;
+        if (results[i])
+        {
+            registers[addr] = value;
+        }
+    }
+}
+
+CPP_AT_CALLBACK(OtherCallback)
+{
+    batch_log += "O";
+    return true;
+}
+
+TEST(CppAT, BatchCallback)
+{
+    CppAT::ATCommandDef_t at_command_list[] = {
+        {.command = "+SET", .min_args = 2, .max_args = 2, .batch_callback = SetRegistersCallback},
+        {.command = "+OTHER", .min_args = 0, .max_args = 0, .callback = OtherCallback}};
+    CppAT parser = CppAT(at_command_list, 2);
+
+    // Long runs are split into batches of kBatchMaxLen calls.
+    std::string message;
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        message += "AT+SET=" + std::to_string(i) + "," + std::to_string(i * 3) + "\r\n";
+    }
+    batch_sizes.clear();
+    ASSERT_TRUE(parser.ParseMessage(message));
+    ASSERT_EQ(batch_sizes, std::vector<size_t>({CppAT::kBatchMaxLen, CppAT::kBatchMaxLen, CppAT::kBatchMaxLen,
+                                                100 - 3 * CppAT::kBatchMaxLen}));
+    ASSERT_EQ(registers[0], 0u);
+    ASSERT_EQ(registers[99], 297u);
+
+    // Other commands end a batch, and everything runs in message order.
+    batch_log.clear();
+    ASSERT_TRUE(parser.ParseMessage("AT+SET=1,1\r\nAT+SET=2,2\r\nAT+OTHER\r\nAT+SET=3,3\r\nAT+OTHER\r\n"));
+    ASSERT_EQ(batch_log, "S2OS1O");
+
+    // A failed call fails the message, and commands after its batch don't run.
+    batch_log.clear();
+    registers[5] = 0;
+    ASSERT_FALSE(parser.ParseMessage("AT+SET=4,4\r\nAT+SET=x,1\r\nAT+SET=5,5\r\nAT+OTHER\r\n"));
+    ASSERT_EQ(batch_log, "S3");
+    ASSERT_EQ(registers[5], 5u); // Calls in the same batch still ran.
+
+    // Calls with the wrong number of arguments are rejected after the calls in front of them run.
+    batch_log.clear();
+    ASSERT_FALSE(parser.ParseMessage("AT+SET=6,6\r\nAT+SET=7\r\nAT+OTHER\r\n"));
+    ASSERT_EQ(batch_log, "S1");
+}
+
+TEST(CppAT, RejectBatchAndRawCallbackTogether)
+{
+    // The same command would otherwise run a different callback as text, as a binary frame and as a script step.
+    CppAT::ATCommandDef_t at_command_list[] = {
+        {.command = "+SET", .raw_callback = RawSumCallback, .batch_callback = SetRegistersCallback}};
+    CppAT parser = CppAT(at_command_list, 1);
+    ASSERT_FALSE(parser.is_valid);
+    ASSERT_EQ(parser.LookupATCommand("+SET"), nullptr);
+    ASSERT_FALSE(parser.ParseMessage("AT+SET=1,1\r\n"));
+
+    CppAT static_parser = CppAT(at_command_list, 1, true);
+    ASSERT_FALSE(static_parser.is_valid);
+}
+
+static uint64_t fake_now_ns = 0;
+static uint64_t FakeClock() { return fake_now_ns; }
+
+CPP_AT_CALLBACK(AdvanceClockCallback)
+{
+    uint32_t duration_us;
+    CPP_AT_TRY_ARG2NUM(0, duration_us);
+    fake_now_ns += duration_us * 1000ull;
+    CPP_AT_SILENT_SUCCESS();
+}
+
+TEST(CppAT, LatencyBudget)
+{
+    CppAT::ATCommandDef_t at_command_list[] = {
+        {.command = "+WAIT", .min_args = 1, .max_args = 1, .callback = AdvanceClockCallback, .latency_budget_us = 100},
+        {.command = "+FREE", .min_args = 1, .max_args = 1, .callback = AdvanceClockCallback}};
+    CppAT parser = CppAT(at_command_list, 2);
+    parser.SetClock(FakeClock);
+    std::string overrun_command;
+    uint64_t overrun_duration_us = 0;
+    parser.SetOverrunHook(
+        [&overrun_command, &overrun_duration_us](const CppAT::ATCommandDef_t &def, uint64_t duration_us)
+        {
+            overrun_command = def.command;
+            overrun_duration_us = duration_us;
+        });
+
+    ASSERT_TRUE(parser.ParseMessage("AT+WAIT=100\r\n"));
+    ASSERT_EQ(parser.GetNumOverruns(), 0u);
+    ASSERT_TRUE(parser.ParseMessage("AT+WAIT=250\r\n"));
+    ASSERT_EQ(parser.GetNumOverruns(), 1u);
+    ASSERT_EQ(overrun_command, "+WAIT");
+    ASSERT_EQ(overrun_duration_us, 250u);
+
+    // Commands without a budget are never timed.
+    ASSERT_TRUE(parser.ParseMessage("AT+FREE=1000\r\n"));
+    ASSERT_EQ(parser.GetNumOverruns(), 1u);
+}
+
 TEST(CppAT, StoreNegativeArgs)
 {
     CppAT parser = BuildStoreArgParser();
@@ -525,4 +817,168 @@ TEST(CppAT, ConstATCommandList)
     ASSERT_EQ(command->help_string.compare("TEST2 help string."), 0);
     ASSERT_EQ(command->command.compare("+TEST2"), 0);
     ASSERT_FALSE(parser.ParseMessage("AT+TEST2?"));
-}
\ No newline at end of file
+}
+// Debug console that only accepts short commands with a single short argument.
+using TinyCppAT = BasicCppAT<8, 1, 16, 32>;
+
+bool tiny_callback_called = false;
+CPP_AT_CALLBACK_FOR(TinyCppAT, TinyCallback)
+{
+    tiny_callback_called = true;
+    return true;
+}
+
+TEST(CppAT, TemplateParameterizedLimits)
+{
+    // Tiny parser only reserves stack and object space for its own limits.
+    static_assert(sizeof(TinyCppAT::ATCommandDef_t) < sizeof(CppAT::ATCommandDef_t));
+    static_assert(sizeof(TinyCppAT) < sizeof(CppAT));
+    static_assert(TinyCppAT::kMaxNumArgs == 1 && TinyCppAT::kArgMaxLen == 16);
+
+    TinyCppAT::ATCommandDef_t tiny_command_list[] = {
+        {.command = "+DBG", .max_args = 1, .help_string = "Debug command.", .callback = TinyCallback}};
+    TinyCppAT tiny_parser = TinyCppAT(tiny_command_list, 1);
+    ASSERT_TRUE(tiny_parser.is_valid);
+
+    // Bulk parser with default limits coexists in the same binary.
+    CppAT parser = BuildStoreArgParser();
+    ASSERT_TRUE(parser.ParseMessage("AT+STORE=1,2,3\r\n"));
+    ASSERT_EQ(stored_args.size(), 3u);
+
+    tiny_callback_called = false;
+    ASSERT_TRUE(tiny_parser.ParseMessage("AT+DBG=1234567890123456\r\n"));
+    ASSERT_TRUE(tiny_callback_called);
+    ASSERT_FALSE(tiny_parser.ParseMessage("AT+DBG=12345678901234567\r\n")); // Argument too long.
+    ASSERT_FALSE(tiny_parser.ParseMessage("AT+DBG=1,2\r\n"));                // Too many arguments.
+}
+
+TEST(CppAT, TemplateParameterizedCommandLen)
+{
+    TinyCppAT::ATCommandDef_t tiny_command_list[] = {{.command = "+TOOLONGCMD"}};
+    TinyCppAT tiny_parser = TinyCppAT(tiny_command_list, 1);
+    ASSERT_FALSE(tiny_parser.is_valid);
+}
+
+TEST(CppAT, TemplateParameterizedCommandTable)
+{
+    // Command table stored inside the parser object instead of in dynamic memory.
+    using TableCppAT = BasicCppAT<8, 1, 16, 32, 2>;
+    TableCppAT::ATCommandDef_t command_list[] = {{.command = "+A"}, {.command = "+B"}, {.command = "+C"}};
+    TableCppAT parser = TableCppAT(command_list, 2);
+    ASSERT_TRUE(parser.is_valid);
+    ASSERT_NE(parser.LookupATCommand("+B"), nullptr);
+    TableCppAT too_many_parser = TableCppAT(command_list, 3);
+    ASSERT_FALSE(too_many_parser.is_valid);
+}
+
+/**
+ * Memory resource that counts what is allocated from it.
+ */
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    uint32_t num_allocations = 0;
+    size_t num_bytes = 0;
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        num_allocations++;
+        num_bytes += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *ptr, size_t bytes, size_t alignment) override
+    {
+        num_bytes -= bytes;
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
+
+static std::string CaptureOutput(CppAT &parser, std::string_view message)
+{
+    char buf[512];
+    CppATOutputBuffer output(buf, sizeof(buf));
+    CppATOutputBuffer::Scope scope(output);
+    parser.ParseMessage(message);
+    return std::string(output.GetContents());
+}
+
+TEST(CppAT, MemoryResource)
+{
+    CountingResource resource;
+    {
+        CppAT::ATCommandDef_t at_command_list[] = {{.command = "+A", .callback = Callback1},
+                                                   {.command = "+B", .callback = Callback2}};
+        CppAT parser = CppAT(at_command_list, 2, false, &resource);
+        ASSERT_TRUE(parser.is_valid);
+        ASSERT_EQ(parser.GetMemoryResource(), &resource);
+        ASSERT_EQ(resource.num_allocations, 1u);
+        ASSERT_EQ(resource.num_bytes, 2 * sizeof(CppAT::ATCommandDef_t));
+
+        // Replacing the list frees the old one.
+        ASSERT_TRUE(parser.SetATCommandList(at_command_list, 1));
+        ASSERT_EQ(resource.num_allocations, 2u);
+        ASSERT_EQ(resource.num_bytes, sizeof(CppAT::ATCommandDef_t));
+    }
+    ASSERT_EQ(resource.num_bytes, 0u);
+}
+
+TEST(CppAT, MoveParser)
+{
+    CountingResource resource;
+    CppAT::ATCommandDef_t at_command_list[] = {{.command = "+A", .help_string = "Moves.", .callback = Callback1}};
+    CppAT parser = CppAT(at_command_list, 1, false, &resource);
+
+    CppAT moved(std::move(parser));
+    ASSERT_EQ(resource.num_allocations, 1u); // Took over the list instead of copying it.
+    ASSERT_TRUE(moved.is_valid);
+    ASSERT_FALSE(parser.is_valid);
+    ASSERT_EQ(parser.GetNumATCommands(), 1u); // Only AT+HELP is left.
+    callback1_was_called = false;
+    ASSERT_TRUE(moved.ParseMessage("AT+A\r\n"));
+    ASSERT_TRUE(callback1_was_called);
+    ASSERT_FALSE(parser.ParseMessage("AT+A\r\n"));
+    // AT+HELP belongs to the new parser.
+    ASSERT_EQ(CaptureOutput(moved, "AT+HELP\r\n"), "AT Command Help Menu:\r\n+A: \r\n\tMoves.\r\n");
+    ASSERT_EQ(CaptureOutput(parser, "AT+HELP\r\n"), "AT Command Help Menu:\r\n");
+
+    CppAT assigned;
+    assigned = std::move(moved);
+    ASSERT_TRUE(assigned.ParseMessage("AT+A\r\n"));
+    assigned = CppAT(at_command_list, 1, false, &resource);
+    ASSERT_EQ(resource.num_bytes, sizeof(CppAT::ATCommandDef_t)); // First list was freed.
+    ASSERT_TRUE(assigned.ParseMessage("AT+A\r\n"));
+
+    // Lists stored in the table inside the parser are copied, with their strings.
+    using TableCppAT = BasicCppAT<8, 1, 16, 32, 2>;
+    TableCppAT::ATCommandDef_t command_list[] = {{.command = "+A"}, {.command = "+B"}};
+    TableCppAT table_parser = TableCppAT(command_list, 2);
+    TableCppAT moved_table_parser(std::move(table_parser));
+    const TableCppAT::ATCommandDef_t *def = moved_table_parser.LookupATCommand("+B");
+    ASSERT_NE(def, nullptr);
+    ASSERT_EQ(def->command.data(), def->command_buf);
+}
+
+TEST(CppAT, ParsersFromArena)
+{
+    // Parsers and their command lists all live in one arena, and are released together without touching the heap.
+    alignas(std::max_align_t) static char arena_buf[2 * 1024 * 1024]; // Heap-free parsers hold a command table.
+    std::pmr::monotonic_buffer_resource arena(arena_buf, sizeof(arena_buf), std::pmr::null_memory_resource());
+    CppAT::ATCommandDef_t at_command_list[] = {{.command = "+A", .callback = Callback1},
+                                               {.command = "+B", .callback = Callback2}};
+    {
+        std::pmr::vector<CppAT> parsers(&arena);
+        for (uint16_t i = 0; i < 20; i++)
+        {
+            parsers.emplace_back(at_command_list, 2, false, &arena); // Growing the vector moves the parsers.
+        }
+        for (CppAT &parser : parsers)
+        {
+            callback2_was_called = false;
+            ASSERT_TRUE(parser.ParseMessage("AT+B\r\n"));
+            ASSERT_TRUE(callback2_was_called);
+        }
+    }
+    arena.release();
+}
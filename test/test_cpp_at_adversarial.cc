@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+#include "cpp_at.hh"
+
+#include <functional>
+#include <random>
+#include <string>
+
+/**
+ * Inputs crafted to hit the worst cases of a tokenizer that rescans the message, checking that ParseMessage dispatches
+ * exactly the commands and arguments they contain at every size. Also replays random inputs, which is mostly useful
+ * under sanitizers.
+ */
+
+static uint32_t num_calls = 0;
+static uint32_t num_args_seen = 0;
+
+CPP_AT_CALLBACK(CountArgsCallback)
+{
+    num_calls++;
+    num_args_seen += num_args;
+    CPP_AT_SILENT_SUCCESS();
+}
+
+CPP_AT_RAW_CALLBACK(CountRawArgsCallback)
+{
+    num_calls++;
+    for (std::string_view arg; args.Next(arg);)
+    {
+        num_args_seen++;
+    }
+    CPP_AT_SILENT_SUCCESS();
+}
+
+static CppAT::ATCommandDef_t at_command_list[] = {
+    {.command = "+A", .min_args = 0, .max_args = CppAT::kMaxNumArgs, .callback = CountArgsCallback},
+    {.command = "+R", .raw_callback = CountRawArgsCallback}};
+
+static std::string Repeat(std::string_view text, size_t count)
+{
+    std::string result;
+    result.reserve(text.length() * count);
+    for (size_t i = 0; i < count; i++)
+    {
+        result += text;
+    }
+    return result;
+}
+
+TEST(CppATAdversarial, LargeInputs)
+{
+    struct Expected_t
+    {
+        bool result;
+        uint32_t num_calls;
+        uint32_t num_args;
+    };
+    struct Case_t
+    {
+        const char *name;
+        std::function<std::string(size_t n)> make;
+        std::function<Expected_t(size_t n)> expected;
+    };
+    const Case_t cases[] = {
+        {"prefix run", [](size_t n) { return Repeat("AT", n); }, [](size_t) { return Expected_t{false, 0, 0}; }},
+        {"no prefix", [](size_t n) { return Repeat("A\r\n", n) + "AT+A"; },
+         [](size_t) { return Expected_t{true, 1, 0}; }},
+        {"long command", [](size_t n) { return "AT" + Repeat("+", n); },
+         [](size_t) { return Expected_t{false, 0, 0}; }},
+        {"op padding", [](size_t n) { return "AT+A=" + Repeat(" ", n) + "1"; },
+         [](size_t) { return Expected_t{true, 1, 1}; }},
+        {"blank lines", [](size_t n) { return "AT+A" + Repeat("\r\n", n) + "AT+A\r\n"; },
+         [](size_t) { return Expected_t{true, 2, 0}; }},
+        {"bare commands", [](size_t n) { return Repeat("AT+A\r\n", n); },
+         [](size_t n) { return Expected_t{true, static_cast<uint32_t>(n), 0}; }},
+        {"commands with args", [](size_t n) { return Repeat("AT+A=1,-2,x,,\r\n", n); },
+         [](size_t n) { return Expected_t{true, static_cast<uint32_t>(n), static_cast<uint32_t>(5 * n)}; }},
+        {"prefixes in args", [](size_t n) { return "AT+R=" + Repeat("ATAT+A,", n) + "\r\n"; },
+         [](size_t n) { return Expected_t{true, 1, static_cast<uint32_t>(n + 1)}; }},
+        {"raw commas", [](size_t n) { return "AT+R=" + Repeat(",", n); },
+         [](size_t n) { return Expected_t{true, 1, static_cast<uint32_t>(n + 1)}; }},
+        {"too many args", [](size_t n) { return "AT+A=" + Repeat(",", n); },
+         [](size_t) { return Expected_t{false, 0, 0}; }},
+    };
+    CppAT parser = CppAT(at_command_list, sizeof(at_command_list) / sizeof(at_command_list[0]));
+    char buf[256];
+    CppATOutputBuffer output(buf, sizeof(buf)); // Swallow error messages, some of them echo the whole input.
+    CppATOutputBuffer::Scope scope(output);
+    for (const Case_t &test_case : cases)
+    {
+        for (size_t n : {size_t(1) << 12, size_t(1) << 16})
+        {
+            std::string message = test_case.make(n);
+            Expected_t expected = test_case.expected(n);
+            num_calls = 0;
+            num_args_seen = 0;
+            output.Clear();
+            EXPECT_EQ(parser.ParseMessage(message), expected.result) << test_case.name << " x" << n;
+            EXPECT_EQ(num_calls, expected.num_calls) << test_case.name << " x" << n;
+            EXPECT_EQ(num_args_seen, expected.num_args) << test_case.name << " x" << n;
+        }
+    }
+}
+
+TEST(CppATAdversarial, RandomInputs)
+{
+    // Random messages built from the characters the tokenizer cares about.
+    static constexpr char kAlphabet[] = "AT+R=?, \r\n-1x";
+    std::mt19937 rng(42);
+    CppAT parser = CppAT(at_command_list, sizeof(at_command_list) / sizeof(at_command_list[0]));
+    char buf[256];
+    CppATOutputBuffer output(buf, sizeof(buf));
+    CppATOutputBuffer::Scope scope(output);
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        std::string message;
+        size_t len = rng() % 64;
+        for (size_t j = 0; j < len; j++)
+        {
+            message += kAlphabet[rng() % (sizeof(kAlphabet) - 1)];
+        }
+        output.Clear();
+        parser.ParseMessage(message);
+    }
+}
@@ -0,0 +1,172 @@
+#include "gtest/gtest.h"
+#include "cpp_at.hh"
+#include "cpp_at_binary.hh"
+
+#include <string>
+#include <vector>
+
+static std::string ArgText(CppATBinary::ArgType type, std::string_view value)
+{
+    char buf[64];
+    size_t len = CppATBinary::ArgToText(type, value, buf, sizeof(buf));
+    return len == SIZE_MAX ? "<error>" : std::string(buf, len);
+}
+
+TEST(CppATBinary, WriteAndReadFrame)
+{
+    uint8_t buf[128];
+    CppATBinary::Writer writer(buf, 0x0102, '=');
+    ASSERT_TRUE(writer.AddText("hi"));
+    ASSERT_TRUE(writer.AddInt(-2));
+    ASSERT_TRUE(writer.AddInt(-40000));
+    ASSERT_TRUE(writer.AddUint(0xFFFFFFFFFFull));
+    ASSERT_TRUE(writer.AddFloat(1.5f));
+    std::string_view frame = writer.GetFrame();
+    ASSERT_EQ(static_cast<uint8_t>(frame[0]), CppATBinary::kLeadByte);
+    ASSERT_EQ(CppATBinary::GetFrameLen(frame), frame.length());
+    ASSERT_EQ(CppATBinary::GetFrameLen(frame.substr(0, 2)), 0u);
+
+    CppATBinary::Header_t header;
+    std::string_view args;
+    ASSERT_TRUE(CppATBinary::ReadHeader(frame, header, args));
+    ASSERT_EQ(header.command_index, 0x0102);
+    ASSERT_EQ(header.op, '=');
+    ASSERT_EQ(header.num_args, 5);
+    std::vector<std::string> texts;
+    std::vector<size_t> lengths;
+    CppATBinary::ArgType type;
+    for (std::string_view value; CppATBinary::ReadArg(args, type, value);)
+    {
+        texts.push_back(ArgText(type, value));
+        lengths.push_back(value.length());
+    }
+    ASSERT_TRUE(args.empty());
+    ASSERT_EQ(texts, std::vector<std::string>({"hi", "-2", "-40000", "1099511627775", "1.5"}));
+    ASSERT_EQ(lengths, std::vector<size_t>({2, 1, 4, 8, 4})); // Integers use the fewest bytes that hold them.
+
+    ASSERT_FALSE(CppATBinary::ReadHeader(frame.substr(0, frame.length() - 1), header, args)); // Truncated.
+    ASSERT_EQ(ArgText(CppATBinary::ArgType::kInt, "abc"), "<error>");                       // Bad integer length.
+    ASSERT_EQ(ArgText(static_cast<CppATBinary::ArgType>(9), "a"), "<error>");               // Unknown type.
+
+    // Frames that don't fit in the buffer are rejected.
+    uint8_t small_buf[12];
+    CppATBinary::Writer small_writer(small_buf, 0);
+    ASSERT_FALSE(small_writer.AddText("too long"));
+    ASSERT_TRUE(small_writer.GetFrame().empty());
+}
+
+static std::vector<std::string> received_args;
+static char received_op;
+CPP_AT_CALLBACK(ReceiveArgsCallback)
+{
+    received_op = op;
+    received_args.clear();
+    for (uint16_t i = 0; i < num_args; i++)
+    {
+        EXPECT_EQ(args[i].data()[args[i].length()], '\0');
+        received_args.push_back(std::string(args[i]));
+    }
+    int32_t number;
+    return num_args < 2 || CppAT::ArgToNum(args[1], number);
+}
+
+CPP_AT_RAW_CALLBACK(ReceiveRawArgsCallback)
+{
+    received_args.clear();
+    for (std::string_view arg : args)
+    {
+        received_args.push_back(std::string(arg));
+    }
+    return true;
+}
+
+static std::vector<size_t> received_batch_sizes;
+CPP_AT_BATCH_CALLBACK(ReceiveBatchCallback)
+{
+    received_batch_sizes.push_back(invocations.size());
+    received_args.assign(invocations[0].args.begin(), invocations[0].args.end());
+    results[0] = true;
+}
+
+TEST(CppATBinary, ParseMessageWithFrames)
+{
+    CppAT::ATCommandDef_t at_command_list[] = {
+        {.command = "+CFG", .min_args = 0, .max_args = 3, .callback = ReceiveArgsCallback},
+        {.command = "+RAW", .raw_callback = ReceiveRawArgsCallback},
+        {.command = "+SET", .min_args = 1, .max_args = 2, .batch_callback = ReceiveBatchCallback}};
+    CppAT parser = CppAT(at_command_list, 3);
+    uint8_t buf[128];
+
+    CppATBinary::Writer cfg(buf, 0, '=');
+    cfg.AddText("a,b");
+    cfg.AddInt(-12);
+    cfg.AddFloat(0.25f);
+    ASSERT_FALSE(parser.ParseMessage(cfg.GetFrame())); // Frames are opt-in, the parser only reads text.
+    ASSERT_TRUE(CppATParseMessageWithFrames(parser, cfg.GetFrame()));
+    ASSERT_EQ(received_op, '=');
+    ASSERT_EQ(received_args, std::vector<std::string>({"a,b", "-12", "0.25"}));
+
+    CppATBinary::Writer raw(buf, 1, '=');
+    raw.AddUint(7);
+    raw.AddText("x");
+    ASSERT_TRUE(CppATParseMessageWithFrames(parser, raw.GetFrame()));
+    ASSERT_EQ(received_args, std::vector<std::string>({"7", "x"}));
+    CppATBinary::Writer raw_with_delimiter(buf, 1, '=');
+    raw_with_delimiter.AddText("x,y");
+    ASSERT_FALSE(CppATParseMessageWithFrames(parser, raw_with_delimiter.GetFrame()));
+
+    CppATBinary::Writer set(buf, 2, '=');
+    set.AddUint(3);
+    ASSERT_TRUE(CppATParseMessageWithFrames(parser, set.GetFrame()));
+    ASSERT_EQ(received_batch_sizes, std::vector<size_t>({1}));
+    ASSERT_EQ(received_args, std::vector<std::string>({"3"}));
+
+    // Help is indexed after the command list.
+    ASSERT_TRUE(CppATParseMessageWithFrames(parser, CppATBinary::Writer(buf, 3).GetFrame()));
+
+    // Unknown commands, wrong numbers of arguments and failed callbacks.
+    ASSERT_FALSE(CppATParseMessageWithFrames(parser, CppATBinary::Writer(buf, 4).GetFrame()));
+    ASSERT_FALSE(CppATParseMessageWithFrames(parser, CppATBinary::Writer(buf, 2).GetFrame()));
+    CppATBinary::Writer bad_number(buf, 0, '=');
+    bad_number.AddText("a");
+    bad_number.AddText("b");
+    ASSERT_FALSE(CppATParseMessageWithFrames(parser, bad_number.GetFrame()));
+
+    // Frames and text can be mixed, frames come first.
+    CppATBinary::Writer first(buf, 0, '?');
+    first.AddText("1");
+    std::string message = std::string(first.GetFrame()) + "AT+CFG=2,3\r\n";
+    ASSERT_TRUE(CppATParseMessageWithFrames(parser, message));
+    ASSERT_EQ(received_args, std::vector<std::string>({"2", "3"}));
+    ASSERT_FALSE(CppATParseMessageWithFrames(parser, message.substr(0, 5))); // Truncated frame.
+}
+
+using TinyBinaryCppAT = BasicCppAT<8, 1, 16, 32>;
+
+CPP_AT_CALLBACK_FOR(TinyBinaryCppAT, TinyReceiveArgsCallback)
+{
+    received_args.assign(args, args + num_args);
+    return true;
+}
+
+TEST(CppATBinary, ParseMessageWithFramesCustomLimits)
+{
+    TinyBinaryCppAT::ATCommandDef_t at_command_list[] = {
+        {.command = "+DBG", .max_args = 1, .callback = TinyReceiveArgsCallback}};
+    TinyBinaryCppAT parser = TinyBinaryCppAT(at_command_list, 1);
+    uint8_t buf[64];
+
+    CppATBinary::Writer dbg(buf, 0, '=');
+    dbg.AddUint(42);
+    ASSERT_TRUE(CppATParseMessageWithFrames(parser, dbg.GetFrame()));
+    ASSERT_EQ(received_args, std::vector<std::string>({"42"}));
+
+    // The parser's own limits apply to frames too.
+    CppATBinary::Writer too_many(buf, 0, '=');
+    too_many.AddUint(1);
+    too_many.AddUint(2);
+    ASSERT_FALSE(CppATParseMessageWithFrames(parser, too_many.GetFrame()));
+    CppATBinary::Writer too_long(buf, 0, '=');
+    too_long.AddText("12345678901234567");
+    ASSERT_FALSE(CppATParseMessageWithFrames(parser, too_long.GetFrame()));
+}
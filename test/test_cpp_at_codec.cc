@@ -0,0 +1,195 @@
+#include "gtest/gtest.h"
+#include "cpp_at.hh"
+#include "cpp_at_codec.hh"
+
+#include <cstring> // for memset
+#include <random>
+#include <string>
+#include <vector>
+
+static std::string EncodeHex(const std::vector<uint8_t> &bytes, bool upper_case)
+{
+    const char *digits = upper_case ? "0123456789ABCDEF" : "0123456789abcdef";
+    std::string hex;
+    for (uint8_t byte : bytes)
+    {
+        hex += digits[byte >> 4];
+        hex += digits[byte & 0x0F];
+    }
+    return hex;
+}
+
+static std::string EncodeBase64(const std::vector<uint8_t> &bytes)
+{
+    static constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string base64;
+    for (size_t i = 0; i < bytes.size(); i += 3)
+    {
+        uint32_t bits = bytes[i] << 16;
+        bits |= i + 1 < bytes.size() ? bytes[i + 1] << 8 : 0;
+        bits |= i + 2 < bytes.size() ? bytes[i + 2] : 0;
+        base64 += kAlphabet[bits >> 18];
+        base64 += kAlphabet[(bits >> 12) & 0x3F];
+        base64 += i + 1 < bytes.size() ? kAlphabet[(bits >> 6) & 0x3F] : '=';
+        base64 += i + 2 < bytes.size() ? kAlphabet[bits & 0x3F] : '=';
+    }
+    return base64;
+}
+
+static std::vector<uint8_t> RandomBytes(std::mt19937 &rng, size_t len)
+{
+    std::vector<uint8_t> bytes(len);
+    for (uint8_t &byte : bytes)
+    {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return bytes;
+}
+
+TEST(CppATCodec, DecodeHex)
+{
+    uint8_t bytes[8];
+    size_t num_bytes = 0;
+    ASSERT_TRUE(CppATCodec::DecodeHex("DEADbeef", bytes, num_bytes));
+    ASSERT_EQ(num_bytes, 4u);
+    ASSERT_EQ(bytes[0], 0xDE);
+    ASSERT_EQ(bytes[3], 0xEF);
+    ASSERT_TRUE(CppATCodec::DecodeHex("", bytes, num_bytes));
+    ASSERT_EQ(num_bytes, 0u);
+
+    ASSERT_FALSE(CppATCodec::DecodeHex("ABC", bytes, num_bytes));                 // Odd length.
+    ASSERT_FALSE(CppATCodec::DecodeHex("0x12", bytes, num_bytes));                // No prefix allowed.
+    ASSERT_FALSE(CppATCodec::DecodeHex("12 34", bytes, num_bytes));               // No separators allowed.
+    ASSERT_FALSE(CppATCodec::DecodeHex("00112233445566778899", bytes, num_bytes)); // Doesn't fit.
+}
+
+TEST(CppATCodec, DecodeHexAllLengths)
+{
+    // Lengths covering the 32 and 16 character SIMD blocks and the scalar tail, with errors in every position.
+    std::mt19937 rng(1234);
+    uint8_t bytes[128];
+    for (size_t len = 0; len <= 100; len++)
+    {
+        std::vector<uint8_t> expected = RandomBytes(rng, len);
+        std::string hex = EncodeHex(expected, len % 2 == 0);
+        size_t num_bytes = 0;
+        ASSERT_TRUE(CppATCodec::DecodeHex(hex, bytes, num_bytes)) << hex;
+        ASSERT_EQ(num_bytes, len);
+        ASSERT_EQ(std::vector<uint8_t>(bytes, bytes + num_bytes), expected) << hex;
+
+        for (size_t i = 0; i < hex.length(); i++)
+        {
+            for (char bad : {'g', 'G', '/', ':', '@', '`', ' ', '\0', '\x80', '\xFF'})
+            {
+                std::string corrupted = hex;
+                corrupted[i] = bad;
+                ASSERT_FALSE(CppATCodec::DecodeHex(corrupted, bytes, num_bytes)) << len << " " << i;
+            }
+        }
+    }
+}
+
+TEST(CppATCodec, DecodeBase64)
+{
+    uint8_t bytes[8];
+    size_t num_bytes = 0;
+    ASSERT_TRUE(CppATCodec::DecodeBase64("3q2+7w==", bytes, num_bytes));
+    ASSERT_EQ(num_bytes, 4u);
+    ASSERT_EQ(bytes[0], 0xDE);
+    ASSERT_EQ(bytes[3], 0xEF);
+    ASSERT_TRUE(CppATCodec::DecodeBase64("", bytes, num_bytes));
+    ASSERT_EQ(num_bytes, 0u);
+
+    ASSERT_FALSE(CppATCodec::DecodeBase64("3q2+7w", bytes, num_bytes));       // Missing padding.
+    ASSERT_FALSE(CppATCodec::DecodeBase64("3q2+7x==", bytes, num_bytes));     // Padding hides set bits.
+    ASSERT_FALSE(CppATCodec::DecodeBase64("3q=+7w==", bytes, num_bytes));     // Padding in the middle.
+    ASSERT_FALSE(CppATCodec::DecodeBase64("3q2-7w==", bytes, num_bytes));     // URL safe alphabet.
+    ASSERT_FALSE(CppATCodec::DecodeBase64("AAAAAAAAAAAA", bytes, num_bytes)); // Doesn't fit.
+
+    // Bytes after the decoded ones are left alone, even when the buffer has room for a whole SIMD store.
+    uint8_t large[64];
+    memset(large, 0xA5, sizeof(large));
+    ASSERT_TRUE(CppATCodec::DecodeBase64("BBBBBBBBBBBBBBBBBA==", large, num_bytes));
+    ASSERT_EQ(num_bytes, 13u);
+    for (size_t i = num_bytes; i < sizeof(large); i++)
+    {
+        ASSERT_EQ(large[i], 0xA5) << i;
+    }
+}
+
+TEST(CppATCodec, DecodeBase64AllLengths)
+{
+    std::mt19937 rng(5678);
+    uint8_t bytes[128];
+    for (size_t len = 0; len <= 96; len++)
+    {
+        std::vector<uint8_t> expected = RandomBytes(rng, len);
+        std::string base64 = EncodeBase64(expected);
+        size_t num_bytes = 0;
+        memset(bytes, 0xA5, sizeof(bytes));
+        ASSERT_TRUE(CppATCodec::DecodeBase64(base64, bytes, num_bytes)) << base64;
+        ASSERT_EQ(num_bytes, len);
+        ASSERT_EQ(std::vector<uint8_t>(bytes, bytes + num_bytes), expected) << base64;
+        ASSERT_EQ(std::vector<uint8_t>(bytes + num_bytes, bytes + sizeof(bytes)),
+                  std::vector<uint8_t>(sizeof(bytes) - num_bytes, 0xA5))
+            << base64;
+
+        // Exactly sized destinations leave no room for the 16 byte SIMD stores.
+        std::vector<uint8_t> exact(len);
+        ASSERT_TRUE(CppATCodec::DecodeBase64(base64, exact, num_bytes));
+        ASSERT_EQ(exact, expected);
+
+        for (size_t i = 0; i < base64.length(); i++)
+        {
+            if (base64[i] == '=')
+            {
+                continue;
+            }
+            for (char bad : {'-', '_', '=', '.', ' ', '\0', '\x80', '\xFF'})
+            {
+                if (bad == '=' && i + 2 >= base64.length())
+                {
+                    continue; // May turn into valid padding.
+                }
+                std::string corrupted = base64;
+                corrupted[i] = bad;
+                ASSERT_FALSE(CppATCodec::DecodeBase64(corrupted, bytes, num_bytes)) << base64 << " " << i;
+            }
+        }
+    }
+}
+
+CPP_AT_CALLBACK(KeyCallback)
+{
+    uint8_t key[16];
+    size_t key_len;
+    if (args[0] == "hex")
+    {
+        CPP_AT_TRY_HEXARG2BYTES(1, key, key_len);
+    }
+    else
+    {
+        CPP_AT_TRY_BASE64ARG2BYTES(1, key, key_len);
+    }
+    CPP_AT_CMD_FORMAT("={},{:02x},{:02x}", key_len, key[0], key[key_len - 1]);
+    CPP_AT_SILENT_SUCCESS();
+}
+
+TEST(CppATCodec, ArgHelpers)
+{
+    uint8_t bytes[4];
+    size_t num_bytes = 0;
+    ASSERT_EQ(CppAT::HexArgToBytes("", bytes, num_bytes), CppAT::ArgError::kBlank);
+    ASSERT_EQ(CppAT::HexArgToBytes("0011223344", bytes, num_bytes), CppAT::ArgError::kOutOfRange);
+    ASSERT_EQ(CppAT::HexArgToBytes("001", bytes, num_bytes), CppAT::ArgError::kInvalid);
+    ASSERT_EQ(CppAT::Base64ArgToBytes("AAAAAAAA", bytes, num_bytes), CppAT::ArgError::kOutOfRange);
+    ASSERT_EQ(CppAT::Base64ArgToBytes("AAA", bytes, num_bytes), CppAT::ArgError::kInvalid);
+
+    CppAT::ATCommandDef_t at_command_list[] = {
+        {.command = "+KEY", .min_args = 2, .max_args = 2, .callback = KeyCallback}};
+    CppAT parser = CppAT(at_command_list, 1);
+    ASSERT_TRUE(parser.ParseMessage("AT+KEY=hex,000102030405060708090a0b0c0d0e0f\r\n"));
+    ASSERT_TRUE(parser.ParseMessage("AT+KEY=b64,AAECAwQFBgcICQoLDA0ODw==\r\n"));
+    ASSERT_FALSE(parser.ParseMessage("AT+KEY=hex,000102030405060708090a0b0c0d0e0f10\r\n"));
+    ASSERT_FALSE(parser.ParseMessage("AT+KEY=b64,AAECAwQFBgcICQoLDA0ODw=\r\n"));
+}
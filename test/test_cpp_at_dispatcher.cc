@@ -0,0 +1,211 @@
+#include "gtest/gtest.h"
+#include "cpp_at.hh"
+#include "cpp_at_dispatcher.hh"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr uint16_t kNumWorkers = 4;
+static constexpr uint16_t kHardwareWorker = 2;
+
+CPP_AT_CALLBACK(SlowEchoCallback)
+{
+    // Later lines finish first, so completions only come out in order if the dispatcher reorders them.
+    uint32_t delay_us;
+    CPP_AT_TRY_ARG2NUM(0, delay_us);
+    std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+    CPP_AT_CMD_FORMAT("={}", delay_us);
+    return delay_us % 2 == 0;
+}
+
+CPP_AT_CALLBACK(HardwareCallback)
+{
+    CPP_AT_CMD_FORMAT("={}", CppATDispatcher::GetWorkerIndex());
+    CPP_AT_SUCCESS();
+}
+
+static CppAT::ATCommandDef_t at_command_list[] = {
+    {.command = "+SLOW", .min_args = 1, .max_args = 1, .callback = SlowEchoCallback},
+    {.command = "+HW", .max_args = 0, .callback = HardwareCallback, .executor = kHardwareWorker},
+    {.command = "+HANG", .min_args = 1, .max_args = 1, .callback = SlowEchoCallback, .latency_budget_us = 20000}};
+
+TEST(CppATDispatcher, OrderedCompletion)
+{
+    CppAT parser = CppAT(at_command_list, 3);
+    CppATDispatcher dispatcher([&parser](std::string_view line) { return parser.ParseMessage(line); }, kNumWorkers,
+                               CppATDispatcherRouter(parser));
+
+    // Two sessions submitting interleaved lines.
+    std::vector<CppATDispatcher::Completion_t> completions[2];
+    std::vector<std::string> outputs[2];
+    CppATDispatcher::Session *sessions[2];
+    for (uint16_t i = 0; i < 2; i++)
+    {
+        sessions[i] = dispatcher.AddSession(
+            [&completions, &outputs, i](const CppATDispatcher::Completion_t &completion)
+            {
+                completions[i].push_back(completion);
+                outputs[i].emplace_back(completion.output);
+            });
+    }
+    constexpr uint32_t kNumLines = 64;
+    for (uint32_t i = 0; i < kNumLines; i++)
+    {
+        for (uint16_t s = 0; s < 2; s++)
+        {
+            std::string line = "AT+SLOW=" + std::to_string((kNumLines - i) * 20 + s) + "\r\n";
+            ASSERT_EQ(dispatcher.Submit(sessions[s], line), i);
+        }
+    }
+    dispatcher.Drain();
+
+    for (uint16_t s = 0; s < 2; s++)
+    {
+        ASSERT_EQ(completions[s].size(), kNumLines);
+        for (uint32_t i = 0; i < kNumLines; i++)
+        {
+            uint32_t delay_us = (kNumLines - i) * 20 + s;
+            EXPECT_EQ(completions[s][i].sequence, i);
+            EXPECT_EQ(completions[s][i].result, delay_us % 2 == 0);
+            EXPECT_EQ(outputs[s][i], "+SLOW=" + std::to_string(delay_us) + "\r\n");
+            EXPECT_LT(completions[s][i].worker_index, kNumWorkers);
+        }
+    }
+}
+
+TEST(CppATDispatcher, PinnedCommands)
+{
+    CppAT parser = CppAT(at_command_list, 3);
+    CppATDispatcher dispatcher([&parser](std::string_view line) { return parser.ParseMessage(line); }, kNumWorkers,
+                               CppATDispatcherRouter(parser));
+    std::vector<std::string> outputs;
+    std::vector<uint16_t> workers;
+    CppATDispatcher::Session *session = dispatcher.AddSession(
+        [&outputs, &workers](const CppATDispatcher::Completion_t &completion)
+        {
+            outputs.emplace_back(completion.output);
+            workers.push_back(completion.worker_index);
+        });
+    for (uint16_t i = 0; i < 50; i++)
+    {
+        dispatcher.Submit(session, "AT+SLOW=10\r\n");
+        dispatcher.Submit(session, "AT+HW\r\n");
+    }
+    dispatcher.RemoveSession(session);
+
+    ASSERT_EQ(outputs.size(), 100u);
+    for (uint16_t i = 1; i < 100; i += 2)
+    {
+        EXPECT_EQ(outputs[i], "+HW=2\r\nOK\r\n");
+        EXPECT_EQ(workers[i], kHardwareWorker);
+    }
+}
+
+TEST(CppATDispatcher, WorkStealing)
+{
+    // Lines that aren't pinned run wherever there is a free worker, so one long line doesn't hold up its queue.
+    std::atomic<uint32_t> num_run = 0;
+    CppATDispatcher dispatcher(
+        [&num_run](std::string_view line)
+        {
+            if (line == "long")
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+            num_run++;
+            return true;
+        },
+        2);
+    uint32_t num_completed = 0;
+    CppATDispatcher::Session *session =
+        dispatcher.AddSession([&num_completed](const CppATDispatcher::Completion_t &) { num_completed++; });
+    dispatcher.Submit(session, "long");
+    for (uint16_t i = 0; i < 99; i++)
+    {
+        dispatcher.Submit(session, "short");
+    }
+    dispatcher.Drain();
+    ASSERT_EQ(num_run, 100u);
+    ASSERT_EQ(num_completed, 100u);
+    ASSERT_GT(dispatcher.GetNumStolen(), 0u);
+}
+
+TEST(CppATDispatcher, Deadlines)
+{
+    CppAT parser = CppAT(at_command_list, 3);
+    CppATDispatcher dispatcher([&parser](std::string_view line) { return parser.ParseMessage(line); }, kNumWorkers,
+                               CppATDispatcherRouter(parser));
+    std::vector<CppATDispatcher::Completion_t> completions;
+    std::vector<std::string> outputs;
+    CppATDispatcher::Session *session = dispatcher.AddSession(
+        [&completions, &outputs](const CppATDispatcher::Completion_t &completion)
+        {
+            completions.push_back(completion);
+            outputs.emplace_back(completion.output);
+        });
+    auto start = std::chrono::steady_clock::now();
+    dispatcher.Submit(session, "AT+HANG=500000\r\n"); // Way past its 20ms budget.
+    dispatcher.Submit(session, "AT+HANG=10\r\n");
+    dispatcher.Submit(session, "AT+SLOW=2\r\n");
+
+    // The hung line is answered at its deadline, so the lines behind it don't wait for it.
+    dispatcher.Drain();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(400));
+    ASSERT_EQ(completions.size(), 3u);
+    EXPECT_TRUE(completions[0].timed_out);
+    EXPECT_FALSE(completions[0].result);
+    EXPECT_EQ(outputs[0], CppATDispatcher::kTimeoutResponse);
+    EXPECT_FALSE(completions[1].timed_out);
+    EXPECT_EQ(outputs[1], "+HANG=10\r\n");
+    EXPECT_EQ(outputs[2], "+SLOW=2\r\n");
+    for (uint64_t i = 0; i < completions.size(); i++)
+    {
+        EXPECT_EQ(completions[i].sequence, i);
+    }
+    EXPECT_EQ(dispatcher.GetNumTimeouts(), 1u);
+
+    // Waits for the hung line to return before the session goes away.
+    dispatcher.RemoveSession(session);
+    EXPECT_EQ(parser.GetNumOverruns(), 1u);
+}
+
+TEST(CppATDispatcher, SlowTimeoutHandlerDoesNotBlockDeadlines)
+{
+    CppAT parser = CppAT(at_command_list, 3);
+    CppATDispatcher dispatcher([&parser](std::string_view line) { return parser.ParseMessage(line); }, kNumWorkers,
+                               CppATDispatcherRouter(parser));
+    std::atomic<bool> timeout_delivered = false;
+    CppATDispatcher::Session *slow_session = dispatcher.AddSession(
+        [&timeout_delivered](const CppATDispatcher::Completion_t &completion)
+        {
+            if (completion.timed_out)
+            {
+                timeout_delivered = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(300)); // e.g. a blocking socket write.
+            }
+        });
+    std::atomic<bool> fast_completed = false;
+    CppATDispatcher::Session *fast_session = dispatcher.AddSession(
+        [&fast_completed](const CppATDispatcher::Completion_t &) { fast_completed = true; });
+
+    dispatcher.Submit(slow_session, "AT+HANG=100000\r\n");
+    while (!timeout_delivered)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Another line with a deadline starts and completes while the slow handler is still running.
+    auto start = std::chrono::steady_clock::now();
+    dispatcher.Submit(fast_session, "AT+HANG=10\r\n");
+    while (!fast_completed && std::chrono::steady_clock::now() - start < std::chrono::seconds(1))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(150));
+
+    dispatcher.RemoveSession(fast_session);
+    dispatcher.RemoveSession(slow_session);
+    EXPECT_EQ(dispatcher.GetNumTimeouts(), 1u);
+}
@@ -0,0 +1,265 @@
+#include "gtest/gtest.h"
+#include "cpp_at.hh"
+#include "cpp_at_binary.hh"
+#include "cpp_at_epoll_server.hh"
+
+#include <fcntl.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+
+CPP_AT_CALLBACK(EchoCallback)
+{
+    CPP_AT_PRINTF("+ECHO: %s\r\n", num_args > 0 ? std::string(args[0]).c_str() : "");
+    CPP_AT_SUCCESS();
+}
+
+static CppAT::ATCommandDef_t at_command_list[] = {{.command = "+ECHO", .max_args = 1, .callback = EchoCallback}};
+
+static CppATEpollServer::LineHandler MakeParserHandler(CppAT &parser)
+{
+    return [&parser](int, std::string_view line) { return parser.ParseMessage(line); };
+}
+
+// Reads from a blocking fd until the expected number of bytes has been received or the server has nothing more to do.
+static std::string ReadResponse(CppATEpollServer &server, int fd, size_t len)
+{
+    std::string response;
+    char buf[256];
+    while (response.length() < len)
+    {
+        server.Poll(0);
+        ssize_t num_read = read(fd, buf, sizeof(buf));
+        if (num_read > 0)
+        {
+            response.append(buf, num_read);
+        }
+        else if (server.Poll(100) == 0)
+        {
+            break;
+        }
+    }
+    return response;
+}
+
+static void SetNonBlocking(int fd) { fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK); }
+
+TEST(CppATOutputBuffer, CapturePrintf)
+{
+    char buf[16];
+    CppATOutputBuffer output(buf, sizeof(buf));
+    {
+        CppATOutputBuffer::Scope scope(output);
+        ASSERT_EQ(CppATOutputBuffer::GetActive(), &output);
+        CppAT::Printf("OK %d\r\n", 5);
+    }
+    ASSERT_EQ(CppATOutputBuffer::GetActive(), nullptr);
+    ASSERT_EQ(output.GetContents(), "OK 5\r\n");
+
+    // Output past the capacity is dropped and counted.
+    output.Printf("0123456789abcdef");
+    ASSERT_EQ(output.GetLength(), output.GetCapacity());
+    ASSERT_EQ(output.GetNumDropped(), 7u);
+    output.Consume(6);
+    ASSERT_EQ(output.GetContents(), "012345678");
+}
+
+TEST(CppATEpollServer, SocketPair)
+{
+    CppAT parser = CppAT(at_command_list, 1);
+    CppATEpollServer server(4);
+    ASSERT_TRUE(server.is_valid);
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ASSERT_TRUE(server.AddFd(fds[0], MakeParserHandler(parser)));
+    SetNonBlocking(fds[1]);
+
+    // Lines split across writes are reassembled before parsing.
+    std::string expected = "+ECHO: hi\r\nOK\r\n";
+    ASSERT_EQ(write(fds[1], "AT+ECHO", 7), 7);
+    server.Poll(0);
+    ASSERT_EQ(write(fds[1], "=hi\r\n", 5), 5);
+    ASSERT_EQ(ReadResponse(server, fds[1], expected.length()), expected);
+
+    // Closing the other end ends the session.
+    close(fds[1]);
+    server.Poll(100);
+    ASSERT_EQ(server.GetNumSessions(), 0);
+}
+
+TEST(CppATEpollServer, HalfClose)
+{
+    CppAT parser = CppAT(at_command_list, 1);
+    CppATEpollServer server(4);
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ASSERT_TRUE(server.AddFd(fds[0], MakeParserHandler(parser)));
+
+    // A client that stops writing right after its command still gets the response before the session closes.
+    ASSERT_EQ(write(fds[1], "AT+ECHO=bye\n", 12), 12);
+    ASSERT_EQ(shutdown(fds[1], SHUT_WR), 0);
+    server.Poll(100);
+    ASSERT_EQ(server.GetNumSessions(), 0);
+    char buf[256];
+    ssize_t num_read = read(fds[1], buf, sizeof(buf));
+    ASSERT_GT(num_read, 0);
+    ASSERT_EQ(std::string(buf, num_read), "+ECHO: bye\r\nOK\r\n");
+    ASSERT_EQ(read(fds[1], buf, sizeof(buf)), 0);
+    close(fds[1]);
+}
+
+TEST(CppATEpollServer, Pty)
+{
+    CppAT parser = CppAT(at_command_list, 1);
+    CppATEpollServer server(4);
+
+    int master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    ASSERT_GE(master_fd, 0);
+    ASSERT_EQ(grantpt(master_fd), 0);
+    ASSERT_EQ(unlockpt(master_fd), 0);
+    int slave_fd = open(ptsname(master_fd), O_RDWR | O_NOCTTY);
+    ASSERT_GE(slave_fd, 0);
+    termios tio;
+    tcgetattr(slave_fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave_fd, TCSANOW, &tio);
+
+    // The server plays the device on the slave side, the test is the host on the master side.
+    ASSERT_TRUE(server.AddFd(slave_fd, MakeParserHandler(parser)));
+    SetNonBlocking(master_fd);
+    ASSERT_EQ(write(master_fd, "AT+ECHO=pty\r\n", 13), 13);
+    std::string expected = "+ECHO: pty\r\nOK\r\n";
+    ASSERT_EQ(ReadResponse(server, master_fd, expected.length()), expected);
+    close(master_fd);
+}
+
+TEST(CppATEpollServer, ListeningSocket)
+{
+    CppAT parser = CppAT(at_command_list, 1);
+    CppATEpollServer server(4);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "/tmp/cpp_at_test_%d.sock", getpid());
+    unlink(addr.sun_path);
+    ASSERT_EQ(bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+    ASSERT_EQ(listen(listen_fd, 4), 0);
+    ASSERT_TRUE(server.AddListener(listen_fd, [&parser](int) { return MakeParserHandler(parser); }));
+
+    int client_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(client_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+    server.Poll(100);
+    ASSERT_EQ(server.GetNumSessions(), 2);
+
+    SetNonBlocking(client_fd);
+    ASSERT_EQ(write(client_fd, "AT+ECHO=unix\r\n", 14), 14);
+    std::string expected = "+ECHO: unix\r\nOK\r\n";
+    ASSERT_EQ(ReadResponse(server, client_fd, expected.length()), expected);
+    close(client_fd);
+    unlink(addr.sun_path);
+}
+
+TEST(CppATEpollServer, ManySessions)
+{
+    constexpr uint16_t kNumSessions = 200;
+    CppAT parser = CppAT(at_command_list, 1);
+    CppATEpollServer server(kNumSessions);
+
+    std::vector<int> client_fds;
+    for (uint16_t i = 0; i < kNumSessions; i++)
+    {
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        ASSERT_TRUE(server.AddFd(fds[0], MakeParserHandler(parser)));
+        SetNonBlocking(fds[1]);
+        client_fds.push_back(fds[1]);
+    }
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ASSERT_FALSE(server.AddFd(fds[0], MakeParserHandler(parser))); // Out of sessions.
+    close(fds[0]);
+    close(fds[1]);
+
+    // Every session gets its own response, even though all of them share one parser and one thread.
+    for (uint16_t i = 0; i < kNumSessions; i++)
+    {
+        std::string command = "AT+ECHO=" + std::to_string(i) + "\r\n";
+        ASSERT_EQ(write(client_fds[i], command.data(), command.length()), static_cast<ssize_t>(command.length()));
+    }
+    while (server.Poll(0) > 0)
+    {
+    }
+    for (uint16_t i = 0; i < kNumSessions; i++)
+    {
+        std::string expected = "+ECHO: " + std::to_string(i) + "\r\nOK\r\n";
+        ASSERT_EQ(ReadResponse(server, client_fds[i], expected.length()), expected);
+    }
+
+    for (int fd : client_fds)
+    {
+        close(fd);
+    }
+    while (server.Poll(0) > 0)
+    {
+    }
+    ASSERT_EQ(server.GetNumSessions(), 0);
+}
+
+TEST(CppATEpollServer, DropOversizedLine)
+{
+    CppAT parser = CppAT(at_command_list, 1);
+    CppATEpollServer server(1);
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ASSERT_TRUE(server.AddFd(fds[0], MakeParserHandler(parser)));
+    SetNonBlocking(fds[1]);
+
+    std::string line = "AT+ECHO=" + std::string(CppATEpollServer::kRxBufferLen, 'x') + "\r\nAT+ECHO=ok\r\n";
+    ASSERT_EQ(write(fds[1], line.data(), line.length()), static_cast<ssize_t>(line.length()));
+    std::string expected = "+ECHO: ok\r\nOK\r\n";
+    ASSERT_EQ(ReadResponse(server, fds[1], expected.length()), expected);
+    ASSERT_EQ(server.GetNumRxDropped(), CppATEpollServer::kRxBufferLen + 10u);
+    close(fds[1]);
+}
+
+TEST(CppATEpollServer, BinaryFrames)
+{
+    CppAT parser = CppAT(at_command_list, 1);
+    CppATEpollServer server(1);
+    server.SetBinaryFrames(true);
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ASSERT_TRUE(server.AddFd(fds[0], [&parser](int, std::string_view line)
+                             { return CppATParseMessageWithFrames(parser, line); }));
+    SetNonBlocking(fds[1]);
+
+    // A frame holding '\n' bytes is passed on whole, even when it arrives in pieces.
+    uint8_t buf[64];
+    CppATBinary::Writer writer(buf, 0, '=');
+    writer.AddText("a\nb");
+    std::string frame(writer.GetFrame());
+    ASSERT_EQ(write(fds[1], frame.data(), 2), 2);
+    server.Poll(0);
+    ASSERT_EQ(write(fds[1], frame.data() + 2, 5), 5);
+    server.Poll(0);
+    std::string rest = frame.substr(7) + "AT+ECHO=text\r\n";
+    ASSERT_EQ(write(fds[1], rest.data(), rest.length()), static_cast<ssize_t>(rest.length()));
+    std::string expected = "+ECHO: a\nb\r\nOK\r\n+ECHO: text\r\nOK\r\n";
+    ASSERT_EQ(ReadResponse(server, fds[1], expected.length()), expected);
+
+    // Frames longer than the receive buffer are dropped without losing the next line.
+    std::vector<uint8_t> large_buf(CppATEpollServer::kRxBufferLen * 2);
+    CppATBinary::Writer large(large_buf, 0, '=');
+    large.AddText(std::string(CppATEpollServer::kRxBufferLen, '\n'));
+    std::string large_frame = std::string(large.GetFrame()) + "AT+ECHO=ok\r\n";
+    ASSERT_EQ(write(fds[1], large_frame.data(), large_frame.length()), static_cast<ssize_t>(large_frame.length()));
+    expected = "+ECHO: ok\r\nOK\r\n";
+    ASSERT_EQ(ReadResponse(server, fds[1], expected.length()), expected);
+    ASSERT_EQ(server.GetNumRxDropped(), large.GetFrame().length());
+    close(fds[1]);
+}
@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+#include "cpp_at.hh"
+#include "cpp_at_format.hh"
+
+#include <string>
+
+template <typename... Args>
+static std::string Format(CppATFormatString<std::type_identity_t<Args>...> format, const Args &...args)
+{
+    char buf[128];
+    size_t len = CppATFormatTo<Args...>(buf, sizeof(buf), format, args...);
+    return std::string(buf, len < sizeof(buf) ? len : sizeof(buf));
+}
+
+enum class TestMode : uint8_t
+{
+    kIdle = 0,
+    kRunning = 3
+};
+
+TEST(CppATFormat, Integers)
+{
+    EXPECT_EQ(Format("no fields"), "no fields");
+    EXPECT_EQ(Format("{} {} {}", 0, -12345, 4000000000u), "0 -12345 4000000000");
+    EXPECT_EQ(Format("{}", INT64_MIN), "-9223372036854775808");
+    EXPECT_EQ(Format("{}", UINT64_MAX), "18446744073709551615");
+    EXPECT_EQ(Format("{:x} {:X} {:b} {:o}", 255, 0xABCDu, 5, 8), "ff ABCD 101 10");
+    EXPECT_EQ(Format("{:04X}", static_cast<uint8_t>(0xA)), "000A");
+    EXPECT_EQ(Format("[{:5}] [{:<5}] [{:05}]", 42, 42, -42), "[   42] [42   ] [-0042]");
+    EXPECT_EQ(Format("{}", TestMode::kRunning), "3"); // Enums don't need a cast.
+    EXPECT_EQ(Format("{{{}}}", 7), "{7}");
+}
+
+TEST(CppATFormat, Floats)
+{
+    EXPECT_EQ(Format("{}", 0.1f), "0.1"); // Shortest representation of the float, not of the promoted double.
+    EXPECT_EQ(Format("{}", 2.5), "2.5");
+    EXPECT_EQ(Format("{:.2f}", 3.14159), "3.14");
+    EXPECT_EQ(Format("{:.3e}", 12345.0), "1.234e+04");
+    EXPECT_EQ(Format("{:8.1f}", -1.25f), "    -1.2");
+    EXPECT_EQ(Format("{:08.3f}", -1.5), "-001.500");
+    EXPECT_EQ(Format("{:.2f}", 1e300).substr(0, 7), "1.00e+3"); // Too long for fixed notation.
+}
+
+TEST(CppATFormat, StringsCharsAndBools)
+{
+    std::string str = "world";
+    const char *null_str = nullptr;
+    EXPECT_EQ(Format("{}, {}!", "hello", str), "hello, world!");
+    EXPECT_EQ(Format("{}", std::string_view("+CFG")), "+CFG");
+    EXPECT_EQ(Format("{}", null_str), "(null)");
+    EXPECT_EQ(Format("[{:6}] [{:>6}] [{:.3}]", "ab", "ab", "abcdef"), "[ab    ] [    ab] [abc]");
+    EXPECT_EQ(Format("{} {:c} {:d} {:x}", 'A', 'B', 'C', 'D'), "A B 67 44");
+    EXPECT_EQ(Format("{} {}", true, false), "true false");
+}
+
+TEST(CppATFormat, Truncate)
+{
+    char buf[8];
+    ASSERT_EQ(CppATFormatTo(buf, sizeof(buf), "{}{}", "0123456", 789), 10u);
+    ASSERT_EQ(std::string_view(buf, sizeof(buf)), "01234567");
+}
+
+TEST(CppATFormat, OutputBuffer)
+{
+    char buf[17];
+    CppATOutputBuffer output(buf, sizeof(buf));
+    {
+        CppATOutputBuffer::Scope scope(output);
+        CppAT::Format("+T: {:.1f}\r\n", 21.56f);
+    }
+    ASSERT_EQ(output.GetContents(), "+T: 21.6\r\n");
+    ASSERT_EQ(output.Format("{}", "0123456789"), 10u);
+    ASSERT_EQ(output.GetContents(), "+T: 21.6\r\n012345");
+    ASSERT_EQ(output.GetNumDropped(), 4u);
+}
+
+TEST(CppATFormat, PrintfFallback)
+{
+    // Without an active output buffer, output goes to cpp_at_printf in pieces of CPP_AT_FORMAT_BUFFER_LEN.
+    std::string long_str(3 * CPP_AT_FORMAT_BUFFER_LEN + 5, 'x');
+    testing::internal::CaptureStdout();
+    ASSERT_EQ(CppAT::Format("[{}] {}", long_str, 1.5), static_cast<int>(long_str.length() + 6));
+    fflush(stdout);
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "[" + long_str + "] 1.5");
+}
+
+CPP_AT_CALLBACK(FormatCallback)
+{
+    if (op == '?')
+    {
+        CPP_AT_CMD_FORMAT("={},{:.2f},{}", 12, 0.5, TestMode::kIdle);
+        CPP_AT_SUCCESS();
+    }
+    CPP_AT_FORMAT_ERROR("{} is not supported.", op);
+}
+
+TEST(CppATFormat, ResponseMacros)
+{
+    CppAT::ATCommandDef_t at_command_list[] = {{.command = "+FMT", .callback = FormatCallback}};
+    CppAT parser = CppAT(at_command_list, 1);
+    char buf[64];
+    CppATOutputBuffer output(buf, sizeof(buf));
+    CppATOutputBuffer::Scope scope(output);
+    ASSERT_TRUE(parser.ParseMessage("AT+FMT?\r\n"));
+    ASSERT_EQ(output.GetContents(), "+FMT=12,0.50,0\r\nOK\r\n");
+    output.Clear();
+    ASSERT_FALSE(parser.ParseMessage("AT+FMT=1\r\n"));
+    ASSERT_EQ(output.GetContents(), "ERROR = is not supported.\r\n");
+}
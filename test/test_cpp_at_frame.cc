@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+#include "cpp_at.hh"
+#include "cpp_at_frame.hh"
+
+#include <string>
+
+static std::string Frame(std::string_view payload)
+{
+    char trailer[CppATFrame::kTrailerMaxLen];
+    size_t trailer_len = CppATFrame::WriteTrailer(payload, trailer, sizeof(trailer));
+    return std::string(payload) + std::string(trailer, trailer_len) + "\r\n";
+}
+
+CPP_AT_CALLBACK(VoltCallback)
+{
+    uint16_t volts;
+    CPP_AT_TRY_ARG2NUM(0, volts);
+    CPP_AT_CMD_FORMAT("={}", volts);
+    CPP_AT_SUCCESS();
+}
+
+TEST(CppATFrame, Crc32c)
+{
+    ASSERT_EQ(CppATFrame::Crc32c(""), 0u);
+    ASSERT_EQ(CppATFrame::Crc32c("123456789"), 0xE3069283u); // Check value from RFC 3720.
+    ASSERT_EQ(CppATFrame::Crc32c("56789", CppATFrame::Crc32c("1234")), 0xE3069283u);
+
+    // Every length and alignment goes through the same value as a byte at a time.
+    std::string data;
+    for (uint16_t i = 0; i < 300; i++)
+    {
+        data += static_cast<char>(i * 7 + 3);
+    }
+    for (size_t offset = 0; offset < 8; offset++)
+    {
+        for (size_t len = 0; offset + len <= data.length(); len += 13)
+        {
+            uint32_t crc = 0;
+            for (size_t i = 0; i < len; i++)
+            {
+                crc = CppATFrame::Crc32c(std::string_view(data).substr(offset + i, 1), crc);
+            }
+            ASSERT_EQ(CppATFrame::Crc32c(std::string_view(data).substr(offset, len)), crc) << offset << " " << len;
+        }
+    }
+}
+
+TEST(CppATFrame, Unframe)
+{
+    std::string_view payload;
+    ASSERT_EQ(Frame("AT+VOLT=12"), "AT+VOLT=12*10:BB3353F8\r\n");
+    ASSERT_TRUE(CppATFrame::Unframe("AT+VOLT=12*10:BB3353F8\r\n", payload));
+    ASSERT_EQ(payload, "AT+VOLT=12");
+    ASSERT_TRUE(CppATFrame::Unframe("AT+VOLT=12*10:bb3353f8", payload)); // Line ending and case don't matter.
+
+    ASSERT_FALSE(CppATFrame::Unframe("AT+VOLT=13*10:BB3353F8\r\n", payload)); // Corrupted payload.
+    ASSERT_FALSE(CppATFrame::Unframe("AT+VOLT=1*10:BB3353F8\r\n", payload));  // Dropped character.
+    ASSERT_FALSE(CppATFrame::Unframe("AT+VOLT=12*10:BB3353F\r\n", payload));  // Short CRC.
+    ASSERT_FALSE(CppATFrame::Unframe("AT+VOLT=12*10BB3353F8\r\n", payload));  // Missing delimiter.
+    ASSERT_FALSE(CppATFrame::Unframe("AT+VOLT=12*:BB3353F8\r\n", payload));   // Missing length.
+    ASSERT_FALSE(CppATFrame::Unframe("AT+VOLT=12\r\n", payload));             // No trailer.
+    ASSERT_FALSE(CppATFrame::Unframe("\r\n", payload));
+}
+
+TEST(CppATFrame, ParseFramedMessage)
+{
+    CppAT::ATCommandDef_t at_command_list[] = {
+        {.command = "+VOLT", .min_args = 1, .max_args = 1, .callback = VoltCallback}};
+    CppAT parser = CppAT(at_command_list, 1);
+    char buf[256];
+    CppATOutputBuffer output(buf, sizeof(buf));
+    CppATOutputBuffer::Scope scope(output);
+
+    ASSERT_TRUE(CppATParseFramedMessage(parser, Frame("AT+VOLT=12")));
+    ASSERT_EQ(output.GetContents(), Frame("+VOLT=12\r\nOK\r\n"));
+    std::string_view payload;
+    std::string response(output.GetContents());
+    ASSERT_TRUE(CppATFrame::Unframe(response, payload));
+    ASSERT_EQ(payload, "+VOLT=12\r\nOK\r\n");
+
+    // A corrupted line never reaches the callback.
+    output.Clear();
+    std::string corrupted = Frame("AT+VOLT=12");
+    corrupted[8] = '7';
+    ASSERT_FALSE(CppATParseFramedMessage(parser, corrupted));
+    response = output.GetContents();
+    ASSERT_TRUE(CppATFrame::Unframe(response, payload));
+    ASSERT_EQ(payload, CppATFrame::kErrorResponse);
+}
+
+using TinyFrameCppAT = BasicCppAT<8, 1, 16, 32>;
+
+CPP_AT_CALLBACK_FOR(TinyFrameCppAT, TinyVoltCallback)
+{
+    CPP_AT_CMD_PRINTF("=%.*s", static_cast<int>(args[0].length()), args[0].data());
+    CPP_AT_SUCCESS();
+}
+
+TEST(CppATFrame, ParseFramedMessageCustomLimits)
+{
+    TinyFrameCppAT::ATCommandDef_t at_command_list[] = {
+        {.command = "+VOLT", .min_args = 1, .max_args = 1, .callback = TinyVoltCallback}};
+    TinyFrameCppAT parser = TinyFrameCppAT(at_command_list, 1);
+    char buf[256];
+    CppATOutputBuffer output(buf, sizeof(buf));
+    CppATOutputBuffer::Scope scope(output);
+
+    ASSERT_TRUE(CppATParseFramedMessage(parser, Frame("AT+VOLT=12")));
+    ASSERT_EQ(output.GetContents(), Frame("+VOLT=12\r\nOK\r\n"));
+}
@@ -0,0 +1,174 @@
+#include "gtest/gtest.h"
+#include "cpp_at.hh"
+#include "cpp_at_profile.hh"
+
+#include <array>
+#include <cstdio> // for remove
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+static std::string ProfilePath(const char *name)
+{
+    std::string path = testing::TempDir() + name;
+    remove(path.c_str());
+    return path;
+}
+
+TEST(CppATProfileStore, SaveAndRestore)
+{
+    std::string path = ProfilePath("cpp_at_profile_save");
+    {
+        CppATProfileStore store;
+        uint16_t *mode = store.AddSetting<uint16_t>("mode", 1);
+        float *gain = store.AddSetting<float>("gain", 1.5f);
+        ASSERT_NE(mode, nullptr);
+        ASSERT_NE(gain, nullptr);
+        ASSERT_TRUE(store.Open(path.c_str()));
+        ASSERT_EQ(store.AddSetting<uint8_t>("late", 0), nullptr); // Layout is fixed once opened.
+        ASSERT_EQ(*mode, 1u);                                    // Nothing saved yet, factory values.
+        ASSERT_EQ(store.GetSequence(), 0u);
+
+        *mode = 2;
+        *gain = 3.0f;
+        ASSERT_TRUE(store.Save());
+        ASSERT_EQ(store.GetSequence(), 1u);
+        *mode = 7;
+        ASSERT_TRUE(store.Restore());
+        ASSERT_EQ(*mode, 2u);
+        store.FactoryReset();
+        ASSERT_EQ(*mode, 1u);
+        ASSERT_EQ(*gain, 1.5f);
+    }
+    {
+        CppATProfileStore store;
+        uint16_t *mode = store.AddSetting<uint16_t>("mode", 1);
+        float *gain = store.AddSetting<float>("gain", 1.5f);
+        ASSERT_TRUE(store.Open(path.c_str()));
+        ASSERT_EQ(*mode, 2u);
+        ASSERT_EQ(*gain, 3.0f);
+        ASSERT_EQ(store.GetSequence(), 1u);
+    }
+    {
+        // A different set of settings doesn't read the old profile.
+        CppATProfileStore store;
+        uint32_t *mode = store.AddSetting<uint32_t>("mode", 9);
+        ASSERT_TRUE(store.Open(path.c_str()));
+        ASSERT_EQ(*mode, 9u);
+    }
+    remove(path.c_str());
+}
+
+TEST(CppATProfileStore, SaveWritesChangedPages)
+{
+    std::string path = ProfilePath("cpp_at_profile_pages");
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    constexpr size_t kBlobLen = 1 << 16;
+    ASSERT_LE(page_size * 4, kBlobLen);
+    CppATProfileStore store(kBlobLen);
+    std::array<uint8_t, kBlobLen> *blob = store.AddSetting("blob", std::array<uint8_t, kBlobLen>{});
+    ASSERT_NE(blob, nullptr);
+    ASSERT_TRUE(store.Open(path.c_str()));
+
+    // Bank 0 is empty, only the changed page and the header are written.
+    (*blob)[page_size * 2] = 1;
+    ASSERT_TRUE(store.Save());
+    ASSERT_EQ(store.GetNumPagesWritten(), 2u);
+
+    // Bank 1 is empty too, and now differs in two pages.
+    (*blob)[0] = 1;
+    ASSERT_TRUE(store.Save());
+    ASSERT_EQ(store.GetNumPagesWritten(), 2u + 3u);
+
+    // Nothing changed.
+    ASSERT_TRUE(store.Save());
+    ASSERT_EQ(store.GetNumPagesWritten(), 5u);
+
+    // Bank 0 is missing the change to page 0 and the new change to page 3.
+    (*blob)[page_size * 3] = 1;
+    ASSERT_TRUE(store.Save());
+    ASSERT_EQ(store.GetNumPagesWritten(), 5u + 3u);
+    remove(path.c_str());
+}
+
+TEST(CppATProfileStore, InterruptedSaveKeepsPreviousProfile)
+{
+    std::string path = ProfilePath("cpp_at_profile_torn");
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    {
+        CppATProfileStore store(page_size);
+        uint32_t *value = store.AddSetting<uint32_t>("value", 0);
+        ASSERT_TRUE(store.Open(path.c_str()));
+        *value = 1;
+        ASSERT_TRUE(store.Save()); // Bank 0.
+        *value = 2;
+        ASSERT_TRUE(store.Save()); // Bank 1.
+    }
+
+    // Corrupt the values of bank 1, as if power was lost while writing them.
+    int fd = open(path.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    uint32_t garbage = 0xDEADBEEF;
+    ASSERT_EQ(pwrite(fd, &garbage, sizeof(garbage), page_size * 3), static_cast<ssize_t>(sizeof(garbage)));
+    close(fd);
+
+    CppATProfileStore store(page_size);
+    uint32_t *value = store.AddSetting<uint32_t>("value", 0);
+    ASSERT_TRUE(store.Open(path.c_str()));
+    ASSERT_EQ(*value, 1u);
+    ASSERT_EQ(store.GetSequence(), 1u);
+
+    // The next save goes to the torn bank.
+    *value = 3;
+    ASSERT_TRUE(store.Save());
+    ASSERT_EQ(store.GetSequence(), 2u);
+    remove(path.c_str());
+}
+
+static uint16_t *volume = nullptr;
+
+CPP_AT_CALLBACK(VolumeCallback)
+{
+    if (op == '=')
+    {
+        CPP_AT_TRY_ARG2NUM(0, *volume);
+    }
+    CPP_AT_SUCCESS();
+}
+
+static std::string CaptureOutput(CppAT &parser, std::string_view message)
+{
+    char buf[512];
+    CppATOutputBuffer output(buf, sizeof(buf));
+    CppATOutputBuffer::Scope scope(output);
+    parser.ParseMessage(message);
+    return std::string(output.GetContents());
+}
+
+TEST(CppATProfileStore, ProfileCommands)
+{
+    std::string path = ProfilePath("cpp_at_profile_commands");
+    CppATProfileStore store;
+    volume = store.AddSetting<uint16_t>("volume", 5);
+    ASSERT_TRUE(store.Open(path.c_str()));
+
+    CppAT::ATCommandDef_t at_command_list[] = {
+        {.command = "+VOL", .min_args = 0, .max_args = 1, .help_string = "Volume.", .callback = VolumeCallback}};
+    CppAT parser = CppAT(at_command_list, 1);
+    ASSERT_FALSE(parser.ParseMessage("AT&W\r\n"));
+    ASSERT_EQ(parser.GetNumATCommands(), 2u);
+
+    parser.SetProfileStore(&store);
+    ASSERT_EQ(parser.GetNumATCommands(), 5u);
+    ASSERT_EQ(parser.GetATCommandIndex(parser.LookupATCommand("&F")), 4u);
+    ASSERT_EQ(parser.GetATCommand(3)->command, "Z");
+    ASSERT_EQ(CaptureOutput(parser, "AT+VOL=8\r\nAT&W\r\n"), "OK\r\nOK\r\n");
+    ASSERT_EQ(CaptureOutput(parser, "AT+VOL=9\r\nATZ\r\n"), "OK\r\nOK\r\n");
+    ASSERT_EQ(*volume, 8u);
+    ASSERT_TRUE(parser.ParseMessage("AT&F\r\n"));
+    ASSERT_EQ(*volume, 5u);
+    ASSERT_TRUE(parser.ParseMessage("ATZ\r\n"));
+    ASSERT_EQ(*volume, 8u);
+    ASSERT_NE(CaptureOutput(parser, "AT+HELP\r\n").find("&W: \r\n\tSave settings."), std::string::npos);
+    remove(path.c_str());
+}
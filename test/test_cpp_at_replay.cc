@@ -0,0 +1,156 @@
+#include "gtest/gtest.h"
+#include "cpp_at.hh"
+#include "cpp_at_replay.hh"
+
+#include <atomic>
+#include <cstdio> // for tmpfile
+#include <string>
+#include <unistd.h> // for getpid
+
+static std::string BuildCapture(uint32_t num_lines)
+{
+    std::string capture;
+    for (uint32_t i = 0; i < num_lines; i++)
+    {
+        capture += "AT+SEQ=" + std::to_string(i) + "\r\n";
+        // Responses in the capture are skipped, even when they contain "AT".
+        capture += "+SEQ: " + std::to_string(i) + ",STATE\r\n";
+        capture += "OK\r\n";
+        if (i % 10 == 0)
+        {
+            capture += "AT+OTHER?\r\n";
+        }
+    }
+    return capture;
+}
+
+TEST(CppATReplay, SplitChunksOnLineBoundaries)
+{
+    std::string capture = BuildCapture(1000);
+    CppATReplay replay;
+    replay.SetCapture(capture);
+    std::vector<std::string_view> chunks = replay.SplitChunks(7);
+    ASSERT_GT(chunks.size(), 1u);
+    size_t total_len = 0;
+    for (std::string_view chunk : chunks)
+    {
+        ASSERT_EQ(chunk.data(), capture.data() + total_len); // Chunks are contiguous and in order.
+        ASSERT_EQ(chunk.back(), '\n');
+        total_len += chunk.length();
+    }
+    ASSERT_EQ(total_len, capture.length());
+}
+
+TEST(CppATReplay, PerChunkStats)
+{
+    std::string capture = BuildCapture(1000);
+    CppATReplay replay;
+    replay.SetCapture(capture);
+
+    std::atomic<uint32_t> num_parsed = 0;
+    CppATReplay::Summary_t summary = replay.Run(
+        [&num_parsed](uint16_t) -> CppATReplay::LineHandler
+        {
+            return [&num_parsed](std::string_view line)
+            {
+                num_parsed++;
+                return line.find("OTHER") == std::string_view::npos; // Count +OTHER as a failure.
+            };
+        },
+        4, CppATReplay::Mode::kPerChunk);
+    ASSERT_EQ(summary.num_lines, 1100u);
+    ASSERT_EQ(summary.num_skipped, 2000u);
+    ASSERT_EQ(summary.num_failures, 100u);
+    ASSERT_EQ(num_parsed, 1100u);
+
+    const std::vector<CppATReplay::CommandStats_t> &stats = replay.GetCommandStats();
+    ASSERT_EQ(stats.size(), 2u);
+    EXPECT_EQ(stats[0].command, "+OTHER");
+    EXPECT_EQ(stats[0].num_calls, 100u);
+    EXPECT_EQ(stats[0].num_failures, 100u);
+    EXPECT_EQ(stats[1].command, "+SEQ");
+    EXPECT_EQ(stats[1].num_calls, 1000u);
+    EXPECT_EQ(stats[1].num_failures, 0u);
+}
+
+static uint32_t replay_next_seq = 0;
+static bool replay_in_order = true;
+CPP_AT_CALLBACK(ReplaySeqCallback)
+{
+    uint32_t seq;
+    CPP_AT_TRY_ARG2NUM(0, seq);
+    replay_in_order = replay_in_order && seq == replay_next_seq;
+    replay_next_seq = seq + 1;
+    return true;
+}
+
+TEST(CppATReplay, OrderedModeThroughParser)
+{
+    std::string capture = BuildCapture(5000);
+    CppATReplay replay;
+    replay.SetCapture(capture);
+
+    CppAT::ATCommandDef_t at_command_list[] = {
+        {.command = "+SEQ", .min_args = 1, .max_args = 1, .callback = ReplaySeqCallback}};
+    CppAT parser = CppAT(at_command_list, 1);
+    replay_next_seq = 0;
+    replay_in_order = true;
+    CppATReplay::Summary_t summary = replay.Run(
+        [&parser](uint16_t) -> CppATReplay::LineHandler
+        { return [&parser](std::string_view line) { return parser.ParseMessage(line); }; },
+        8, CppATReplay::Mode::kOrdered);
+    ASSERT_TRUE(replay_in_order);
+    ASSERT_EQ(replay_next_seq, 5000u);
+    ASSERT_EQ(summary.num_lines, 5500u);
+    ASSERT_EQ(summary.num_failures, 500u); // +OTHER isn't in the command list.
+}
+
+TEST(CppATReplay, ResponsesContainingATAreSkipped)
+{
+    std::string capture = "AT+STATUS?\r\n+STATUS: 1\r\nOK\r\n"
+                          "  AT+DATA=12\r\nDATA 12\r\nNOT READY\r\nERROR\r\n"
+                          "\tAT+STATUS?\r\nLOG: AT+STATUS? took 3 ms\r\n";
+    CppATReplay replay;
+    replay.SetCapture(capture);
+
+    std::vector<std::string> handled;
+    CppATReplay::Summary_t summary = replay.Run(
+        [&handled](uint16_t) -> CppATReplay::LineHandler
+        {
+            return [&handled](std::string_view line)
+            {
+                handled.push_back(std::string(line));
+                return true;
+            };
+        },
+        1, CppATReplay::Mode::kOrdered);
+    ASSERT_EQ(summary.num_lines, 3u);
+    ASSERT_EQ(summary.num_skipped, 6u);
+    ASSERT_EQ(handled, std::vector<std::string>({"AT+STATUS?", "  AT+DATA=12", "\tAT+STATUS?"}));
+
+    const std::vector<CppATReplay::CommandStats_t> &stats = replay.GetCommandStats();
+    ASSERT_EQ(stats.size(), 2u);
+    EXPECT_EQ(stats[0].command, "+DATA");
+    EXPECT_EQ(stats[0].num_calls, 1u);
+    EXPECT_EQ(stats[1].command, "+STATUS");
+    EXPECT_EQ(stats[1].num_calls, 2u);
+}
+
+TEST(CppATReplay, OpenMappedCapture)
+{
+    std::string capture = BuildCapture(100);
+    std::string path = "/tmp/cpp_at_replay_test_" + std::to_string(getpid()) + ".txt";
+    FILE *file = fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    fwrite(capture.data(), 1, capture.length(), file);
+    fclose(file);
+
+    CppATReplay replay;
+    ASSERT_TRUE(replay.Open(path.c_str()));
+    CppATReplay::Summary_t summary = replay.Run(nullptr, 2);
+    EXPECT_EQ(summary.num_bytes, capture.length());
+    EXPECT_EQ(summary.num_lines, 110u);
+    remove(path.c_str());
+
+    ASSERT_FALSE(replay.Open("/tmp/this/file/does/not/exist"));
+}
@@ -0,0 +1,205 @@
+#include "gtest/gtest.h"
+#include "cpp_at.hh"
+#include "cpp_at_script.hh"
+
+#include <string>
+#include <vector>
+
+static std::vector<std::string> StepArgs(const CppATScriptStore &store, const CppATScriptStore::Step_t &step)
+{
+    std::vector<std::string> args;
+    for (uint16_t i = 0; i < step.num_args; i++)
+    {
+        args.push_back(std::string(store.GetArgs(step)[i]));
+    }
+    return args;
+}
+
+static bool AddStep(CppATScriptStore &store, uint16_t command_index, std::string_view args_string,
+                    std::vector<std::string_view> args)
+{
+    CppATScriptStore::Step_t step;
+    step.command_index = command_index;
+    step.op = '=';
+    return store.AddStep(step, args_string, args);
+}
+
+TEST(CppATScriptStore, ReplaceAndRemove)
+{
+    CppATScriptStore store;
+    ASSERT_TRUE(store.BeginScript("a"));
+    ASSERT_TRUE(AddStep(store, 0, "1,2", {"1", "2"}));
+    ASSERT_TRUE(AddStep(store, 1, "x", {"x"}));
+    ASSERT_TRUE(store.CommitScript());
+    ASSERT_TRUE(store.BeginScript("b"));
+    ASSERT_TRUE(AddStep(store, 2, "3", {"3"}));
+    ASSERT_TRUE(store.CommitScript());
+
+    // Replacing a script moves the scripts after it, and the new one goes last.
+    ASSERT_TRUE(store.BeginScript("a"));
+    ASSERT_TRUE(AddStep(store, 3, "long,er", {"long", "er"}));
+    ASSERT_TRUE(store.CommitScript());
+    ASSERT_EQ(store.GetNumScripts(), 2u);
+    ASSERT_EQ(store.GetScriptName(0), "b");
+    ASSERT_EQ(store.GetNumSteps(1), 1u);
+
+    std::span<const CppATScriptStore::Step_t> b = store.GetScript("b");
+    ASSERT_EQ(b.size(), 1u);
+    ASSERT_EQ(b[0].command_index, 2u);
+    ASSERT_EQ(b[0].args_string, "3");
+    ASSERT_EQ(StepArgs(store, b[0]), std::vector<std::string>({"3"}));
+    std::span<const CppATScriptStore::Step_t> a = store.GetScript("a");
+    ASSERT_EQ(a.size(), 1u);
+    ASSERT_EQ(a[0].args_string, "long,er");
+    ASSERT_EQ(a[0].args_string.data()[a[0].args_string.length()], '\0');
+    ASSERT_EQ(StepArgs(store, a[0]), std::vector<std::string>({"long", "er"}));
+
+    ASSERT_TRUE(store.RemoveScript("b"));
+    ASSERT_FALSE(store.RemoveScript("b"));
+    a = store.GetScript("a");
+    ASSERT_EQ(a[0].command_index, 3u);
+    ASSERT_EQ(a[0].args_string, "long,er");
+    ASSERT_EQ(StepArgs(store, a[0]), std::vector<std::string>({"long", "er"}));
+
+    // Aborted and empty scripts aren't stored.
+    ASSERT_TRUE(store.BeginScript("c"));
+    ASSERT_TRUE(AddStep(store, 0, "", {}));
+    store.AbortScript();
+    ASSERT_TRUE(store.BeginScript("d"));
+    ASSERT_FALSE(store.CommitScript());
+    ASSERT_EQ(store.GetNumScripts(), 1u);
+    ASSERT_FALSE(store.BeginScript(""));
+    ASSERT_FALSE(store.BeginScript(std::string(CppATScriptStore::kNameMaxLen + 1, 'n')));
+
+    // Steps that don't fit are rejected.
+    ASSERT_TRUE(store.BeginScript("big"));
+    std::string text(CppATScriptStore::kTextLen, 't');
+    ASSERT_FALSE(AddStep(store, 0, text, {}));
+    store.AbortScript();
+
+    store.Clear();
+    ASSERT_EQ(store.GetNumScripts(), 0u);
+    ASSERT_TRUE(store.GetScript("a").empty());
+}
+
+static std::vector<std::string> calls;
+
+CPP_AT_CALLBACK(RecordCallback)
+{
+    std::string call = std::string(def.command) + (op == '\0' ? "" : std::string(1, op));
+    for (uint16_t i = 0; i < num_args; i++)
+    {
+        EXPECT_EQ(args[i].data()[args[i].length()], '\0');
+        call += (i == 0 ? "" : ",") + std::string(args[i]);
+    }
+    calls.push_back(call);
+    return true;
+}
+
+CPP_AT_CALLBACK(FailCallback)
+{
+    calls.push_back("+FAIL");
+    return false;
+}
+
+CPP_AT_RAW_CALLBACK(RecordRawCallback)
+{
+    calls.push_back(std::string(def.command) + std::string(1, op) + std::string(args.GetString()));
+    return true;
+}
+
+CPP_AT_BATCH_CALLBACK(RecordBatchCallback)
+{
+    for (size_t i = 0; i < invocations.size(); i++)
+    {
+        calls.push_back(std::string(def.command) + std::string(1, invocations[i].op) +
+                        std::string(invocations[i].args_string));
+        results[i] = true;
+    }
+}
+
+static std::string CaptureOutput(CppAT &parser, std::string_view message)
+{
+    char buf[512];
+    CppATOutputBuffer output(buf, sizeof(buf));
+    CppATOutputBuffer::Scope scope(output);
+    parser.ParseMessage(message);
+    return std::string(output.GetContents());
+}
+
+TEST(CppATScript, RunScript)
+{
+    CppAT::ATCommandDef_t at_command_list[] = {
+        {.command = "+CFG", .min_args = 0, .max_args = 3, .callback = RecordCallback},
+        {.command = "+RAW", .raw_callback = RecordRawCallback},
+        {.command = "+SET", .min_args = 1, .max_args = 2, .batch_callback = RecordBatchCallback},
+        {.command = "+FAIL", .callback = FailCallback}};
+    CppAT parser = CppAT(at_command_list, 4);
+    CppATScriptStore store;
+    ASSERT_FALSE(parser.StoreScript("init", "+CFG=1"));
+    parser.SetScriptStore(&store);
+    ASSERT_EQ(parser.GetNumATCommands(), 7u);
+    ASSERT_EQ(parser.GetATCommand(6), parser.LookupATCommand("+RUN"));
+
+    ASSERT_TRUE(parser.StoreScript("init", "+CFG=1, 2;+RAW=a,b; +SET=5,6;~+FAIL;+CFG?;+CFG"));
+    calls.clear();
+    ASSERT_TRUE(parser.RunScript("init"));
+    ASSERT_EQ(calls, std::vector<std::string>({"+CFG=1, 2", "+RAW=a,b", "+SET=5,6", "+FAIL", "+CFG?", "+CFG"}));
+
+    // The first failing step aborts the script.
+    ASSERT_TRUE(parser.StoreScript("abort", "+CFG=1;+FAIL;+CFG=2"));
+    calls.clear();
+    uint16_t failed_step = UINT16_MAX;
+    ASSERT_FALSE(parser.RunScript("abort", &failed_step));
+    ASSERT_EQ(failed_step, 1u);
+    ASSERT_EQ(calls, std::vector<std::string>({"+CFG=1", "+FAIL"}));
+    ASSERT_FALSE(parser.RunScript("missing"));
+
+    // Scripts are checked when they are stored, and bad scripts aren't stored at all.
+    ASSERT_FALSE(parser.StoreScript("bad", "+CFG=1;+NOPE"));
+    ASSERT_FALSE(parser.StoreScript("bad", "+CFG=1,2,3,4"));
+    ASSERT_FALSE(parser.StoreScript("bad", "+SET"));
+    ASSERT_FALSE(parser.StoreScript("bad", std::string("+CFG=") + std::string(CPP_AT_ARG_MAX_LEN + 1, 'a')));
+    ASSERT_FALSE(parser.StoreScript("bad", "+CFG;"));
+    ASSERT_FALSE(parser.StoreScript("bad", "+RUN=init"));
+    ASSERT_FALSE(parser.RunScript("bad"));
+
+    // Over AT commands.
+    ASSERT_EQ(CaptureOutput(parser, "AT+SCRIPT=boot,+CFG=7;+SET=8\r\n"), "OK\r\n");
+    ASSERT_EQ(CaptureOutput(parser, "AT+SCRIPT?\r\n"),
+              "+SCRIPT: init,6\r\n+SCRIPT: abort,3\r\n+SCRIPT: boot,2\r\nOK\r\n");
+    calls.clear();
+    ASSERT_EQ(CaptureOutput(parser, "AT+RUN=boot\r\n"), "OK\r\n");
+    ASSERT_EQ(calls, std::vector<std::string>({"+CFG=7", "+SET=8"}));
+    ASSERT_EQ(CaptureOutput(parser, "AT+RUN=abort\r\n"), "+RUN: 1\r\nERROR\r\n");
+    ASSERT_EQ(CaptureOutput(parser, "AT+SCRIPT=abort\r\n"), "OK\r\n");
+    ASSERT_FALSE(parser.RunScript("abort"));
+    ASSERT_NE(CaptureOutput(parser, "AT+SCRIPT=x,+NOPE\r\n").find("ERROR\r\n"), std::string::npos);
+
+    // Changing the commands clears the scripts, since they refer to commands by index.
+    parser.SetATCommandList(at_command_list, 1);
+    ASSERT_EQ(store.GetNumScripts(), 0u);
+}
+
+TEST(CppATScript, MoveParser)
+{
+    CppAT::ATCommandDef_t at_command_list[] = {{.command = "+CFG", .max_args = 3, .callback = RecordCallback}};
+    CppAT parser = CppAT(at_command_list, 1);
+    CppATScriptStore store;
+    parser.SetScriptStore(&store);
+    ASSERT_TRUE(parser.StoreScript("init", "+CFG=1"));
+
+    // The store moves with the parser, and the moved from parser lets go of it.
+    CppAT moved(std::move(parser));
+    ASSERT_EQ(parser.GetNumATCommands(), 1u);
+    ASSERT_FALSE(parser.StoreScript("other", "+CFG=2"));
+    ASSERT_EQ(moved.GetNumATCommands(), 4u);
+    calls.clear();
+    ASSERT_TRUE(moved.RunScript("init"));
+    ASSERT_EQ(calls, std::vector<std::string>({"+CFG=1"}));
+
+    CppAT assigned;
+    assigned = std::move(moved);
+    ASSERT_FALSE(moved.RunScript("init"));
+    ASSERT_TRUE(assigned.RunScript("init"));
+}
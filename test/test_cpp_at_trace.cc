@@ -0,0 +1,174 @@
+#include "gtest/gtest.h"
+#include "cpp_at.hh"
+#include "cpp_at_trace.hh"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+static uint64_t fake_time_ns = 0;
+static uint64_t FakeClock() { return fake_time_ns += 1000; }
+
+CPP_AT_CALLBACK(TraceCallback) { return num_args == 0 || args[0].compare("fail") != 0; }
+
+static std::string DumpTrace(CppAT &parser, const CppATTraceBuffer &trace)
+{
+    std::string dump;
+    CppATTraceDump(parser, trace,
+                   [&dump](const uint8_t *data, size_t len)
+                   { dump.append(reinterpret_cast<const char *>(data), len); });
+    return dump;
+}
+
+TEST(CppATTrace, RecordParsedCommands)
+{
+    CppAT::ATCommandDef_t at_command_list[] = {
+        {.command = "+CFG", .max_args = 3, .callback = TraceCallback},
+        {.command = "+RUN", .max_args = 0, .callback = TraceCallback}};
+    CppAT parser = CppAT(at_command_list, 2);
+    CppATTraceRingBuffer<16> trace;
+    trace.SetClock(FakeClock);
+    fake_time_ns = 0;
+    parser.SetTraceBuffer(&trace);
+
+    ASSERT_TRUE(parser.ParseMessage("AT+CFG=1,2,3\r\nAT+RUN\r\n"));
+    ASSERT_FALSE(parser.ParseMessage("AT+CFG=fail\r\n"));
+    ASSERT_FALSE(parser.ParseMessage("AT+NOPE?\r\n"));
+    ASSERT_FALSE(parser.ParseMessage("AT+RUN=1\r\n"));
+    ASSERT_EQ(trace.GetHead(), 5u);
+
+    CppATTraceBuffer::Record_t record;
+    ASSERT_TRUE(trace.ReadRecord(0, record));
+    EXPECT_EQ(record.command_index, 0);
+    EXPECT_EQ(record.op, '=');
+    EXPECT_EQ(record.num_args, 3);
+    EXPECT_EQ(record.args_len, 5);
+    EXPECT_EQ(record.args_hash, CppATTraceBuffer::Hash("1,2,3"));
+    EXPECT_EQ(record.result, CppATTraceBuffer::Result::kOK);
+    EXPECT_EQ(record.duration_ns, 1000u);
+    ASSERT_TRUE(trace.ReadRecord(1, record));
+    EXPECT_EQ(record.command_index, 1);
+    ASSERT_TRUE(trace.ReadRecord(2, record));
+    EXPECT_EQ(record.result, CppATTraceBuffer::Result::kError);
+    ASSERT_TRUE(trace.ReadRecord(3, record));
+    EXPECT_EQ(record.command_index, CppATTraceBuffer::kCommandIndexNone);
+    EXPECT_EQ(record.result, CppATTraceBuffer::Result::kUnknownCommand);
+    ASSERT_TRUE(trace.ReadRecord(4, record));
+    EXPECT_EQ(record.result, CppATTraceBuffer::Result::kBadArgs);
+
+    // Dump and decode back into text.
+    CppATTraceDecoder decoder;
+    ASSERT_TRUE(decoder.Load(DumpTrace(parser, trace)));
+    ASSERT_EQ(decoder.GetNumRecords(), 5u);
+    EXPECT_EQ(decoder.GetCommand(2), "+HELP");
+    EXPECT_EQ(decoder.FormatRecord(0), "[0.000001000] AT+CFG=1,2,3 -> OK (1.000 us)");
+    EXPECT_EQ(decoder.FormatRecord(1), "[0.000003000] AT+RUN -> OK (1.000 us)");
+    EXPECT_EQ(decoder.FormatRecord(2), "[0.000005000] AT+CFG=fail -> ERROR (1.000 us)");
+    EXPECT_EQ(decoder.FormatRecord(3), "[0.000007000] AT+NOPE -> UNKNOWN COMMAND (0.000 us)");
+    EXPECT_EQ(decoder.FormatRecord(4), "[0.000008000] AT+RUN=1 -> BAD ARGS (0.000 us)");
+
+    ASSERT_FALSE(decoder.Load("not a dump"));
+}
+
+TEST(CppATTrace, LongArgumentsKeepHash)
+{
+    CppAT::ATCommandDef_t at_command_list[] = {{.command = "+CFG", .max_args = 10, .callback = TraceCallback}};
+    CppAT parser = CppAT(at_command_list, 1);
+    CppATTraceRingBuffer<4> trace;
+    trace.SetClock(FakeClock);
+    fake_time_ns = 0;
+    parser.SetTraceBuffer(&trace);
+    ASSERT_TRUE(parser.ParseMessage("AT+CFG=0123456789,abcdefghij\r\n"));
+
+    CppATTraceDecoder decoder;
+    ASSERT_TRUE(decoder.Load(DumpTrace(parser, trace)));
+    char expected[128];
+    snprintf(expected, sizeof(expected),
+             "[0.000001000] AT+CFG=0123456789,abcde...(21 chars, hash %08x) -> OK (1.000 us)",
+             CppATTraceBuffer::Hash("0123456789,abcdefghij"));
+    EXPECT_EQ(decoder.FormatRecord(0), expected);
+}
+
+TEST(CppATTrace, OverwriteOldestRecords)
+{
+    CppATTraceRingBuffer<8> trace;
+    for (uint16_t i = 0; i < 20; i++)
+    {
+        trace.Record(i, '=', 0, "", CppATTraceBuffer::Result::kOK, i, 0);
+    }
+    ASSERT_EQ(trace.GetHead(), 20u);
+    ASSERT_EQ(trace.GetTail(), 12u);
+    CppATTraceBuffer::Record_t record;
+    ASSERT_FALSE(trace.ReadRecord(11, record)); // Overwritten.
+    for (uint64_t position = trace.GetTail(); position < trace.GetHead(); position++)
+    {
+        ASSERT_TRUE(trace.ReadRecord(position, record));
+        ASSERT_EQ(record.command_index, position);
+    }
+}
+
+// Trace buffer with its slots exposed, to fake a writer that is still busy with a slot.
+class ExposedTraceBuffer : public CppATTraceBuffer
+{
+public:
+    ExposedTraceBuffer() : CppATTraceBuffer(slots, 4) {}
+    Slot_t slots[4];
+};
+
+TEST(CppATTrace, SlotInUseDropsRecord)
+{
+    ExposedTraceBuffer trace;
+    for (uint16_t i = 0; i < 4; i++)
+    {
+        trace.Record(i, '=', 0, "", CppATTraceBuffer::Result::kOK, i, 0);
+    }
+    // The writer of position 0 is still busy with slot 0 when position 4 comes around.
+    trace.slots[0].seq.store(1);
+    trace.Record(4, '=', 0, "", CppATTraceBuffer::Result::kOK, 4, 0);
+    ASSERT_EQ(trace.slots[0].seq.load(), 1u);
+    CppATTraceBuffer::Record_t record;
+    ASSERT_FALSE(trace.ReadRecord(4, record));
+
+    // Once the slot is free again the next lap writes it normally.
+    trace.slots[0].seq.store(2);
+    for (uint16_t i = 5; i < 9; i++)
+    {
+        trace.Record(i, '=', 0, "", CppATTraceBuffer::Result::kOK, i, 0);
+    }
+    ASSERT_TRUE(trace.ReadRecord(8, record));
+    ASSERT_EQ(record.command_index, 8u);
+}
+
+TEST(CppATTrace, ConcurrentWriters)
+{
+    static CppATTraceRingBuffer<1024> trace;
+    std::vector<std::thread> writers;
+    for (uint16_t thread_index = 0; thread_index < 4; thread_index++)
+    {
+        writers.emplace_back(
+            [thread_index]()
+            {
+                for (uint16_t i = 0; i < 256; i++)
+                {
+                    trace.Record(thread_index, '=', i, "args", CppATTraceBuffer::Result::kOK, i, 0);
+                }
+            });
+    }
+    for (std::thread &writer : writers)
+    {
+        writer.join();
+    }
+    ASSERT_EQ(trace.GetHead(), 1024u);
+    uint32_t num_per_thread[4] = {0};
+    CppATTraceBuffer::Record_t record;
+    for (uint64_t position = 0; position < trace.GetHead(); position++)
+    {
+        ASSERT_TRUE(trace.ReadRecord(position, record));
+        ASSERT_LT(record.command_index, 4);
+        num_per_thread[record.command_index]++;
+    }
+    for (uint32_t num : num_per_thread)
+    {
+        EXPECT_EQ(num, 256u);
+    }
+}
@@ -0,0 +1,113 @@
+/**
+ * cpp_at_replay: Replays a capture of AT traffic through CppAT and prints per-command statistics.
+ *
+ * Usage: cpp_at_replay [-j <num_threads>] [-o] [-v] <capture_file>
+ *  -j  Number of worker threads (defaults to the number of hardware threads).
+ *  -o  Ordered mode: dispatch commands in capture order on a single parser instead of one parser per chunk. Dispatch
+ *      runs on one thread.
+ *  -v  Print parser output instead of discarding it.
+ *
+ * Every command seen in the capture is registered with a callback that accepts any arguments, so the replay measures
+ * prefix scanning, command lookup, tokenization and dispatch. To replay through real handlers, build a
+ * CppATReplay::LineHandlerFactory that returns parsers with your own command list.
+ */
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory> // for std::make_shared
+#include <vector>
+#include "cpp_at.hh"
+#include "cpp_at_replay.hh"
+
+static bool verbose = false;
+
+int CppAT::cpp_at_printf(const char *format, ...)
+{
+    if (!verbose)
+    {
+        return 0;
+    }
+    va_list args;
+    va_start(args, format);
+    int res = vprintf(format, args);
+    va_end(args);
+    return res;
+}
+
+CPP_AT_CALLBACK(ReplayCallback) { return true; }
+
+int main(int argc, char *argv[])
+{
+    uint16_t num_threads = 0;
+    CppATReplay::Mode mode = CppATReplay::Mode::kPerChunk;
+    const char *path = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            num_threads = static_cast<uint16_t>(atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-o") == 0)
+        {
+            mode = CppATReplay::Mode::kOrdered;
+        }
+        else if (strcmp(argv[i], "-v") == 0)
+        {
+            verbose = true;
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+    if (path == nullptr)
+    {
+        fprintf(stderr, "Usage: %s [-j <num_threads>] [-o] [-v] <capture_file>\n", argv[0]);
+        return 1;
+    }
+
+    CppATReplay replay;
+    if (!replay.Open(path))
+    {
+        fprintf(stderr, "Unable to open capture %s.\n", path);
+        return 1;
+    }
+
+    // First pass: find the commands used in the capture.
+    replay.Run(nullptr, num_threads, CppATReplay::Mode::kPerChunk);
+    std::vector<CppAT::ATCommandDef_t> command_list;
+    for (const CppATReplay::CommandStats_t &stats : replay.GetCommandStats())
+    {
+        if (stats.command.length() <= CppAT::kATCommandMaxLen && stats.command != "+HELP")
+        {
+            command_list.push_back(
+                {.command = stats.command, .max_args = CppAT::kMaxNumArgs, .callback = ReplayCallback});
+        }
+    }
+
+    // Second pass: replay the capture through parsers.
+    CppATReplay::Summary_t summary = replay.Run(
+        [&command_list](uint16_t) -> CppATReplay::LineHandler
+        {
+            // Shared pointer keeps the parser alive for as long as the worker holds the handler.
+            auto parser = std::make_shared<CppAT>(command_list.data(), command_list.size());
+            return [parser](std::string_view line) { return parser->ParseMessage(line); };
+        },
+        num_threads, mode);
+
+    printf("%-*s %12s %12s %12s %12s\n", CppAT::kATCommandMaxLen, "COMMAND", "CALLS", "FAILURES", "MEAN_NS",
+           "MAX_NS");
+    for (const CppATReplay::CommandStats_t &stats : replay.GetCommandStats())
+    {
+        printf("%-*s %12llu %12llu %12llu %12llu\n", CppAT::kATCommandMaxLen, stats.command.c_str(),
+               (unsigned long long)stats.num_calls, (unsigned long long)stats.num_failures,
+               (unsigned long long)(stats.num_calls > 0 ? stats.total_ns / stats.num_calls : 0),
+               (unsigned long long)stats.max_ns);
+    }
+    printf("%llu bytes, %llu commands, %llu other lines, %llu failures in %.3f s (%.1f MB/s).\n",
+           (unsigned long long)summary.num_bytes, (unsigned long long)summary.num_lines,
+           (unsigned long long)summary.num_skipped, (unsigned long long)summary.num_failures, summary.wall_ns / 1e9,
+           summary.wall_ns > 0 ? summary.num_bytes * 1e3 / summary.wall_ns : 0.0);
+    return summary.num_failures == 0 ? 0 : 2;
+}
@@ -0,0 +1,38 @@
+/**
+ * cpp_at_trace_decode: Turns a binary CppAT trace dump (written by CppATTraceDump) into readable AT command lines.
+ *
+ * Usage: cpp_at_trace_decode <dump_file>
+ */
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "cpp_at_trace.hh"
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <dump_file>\n", argv[0]);
+        return 1;
+    }
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file)
+    {
+        fprintf(stderr, "Unable to open %s.\n", argv[1]);
+        return 1;
+    }
+    std::string dump((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    CppATTraceDecoder decoder;
+    if (!decoder.Load(dump))
+    {
+        fprintf(stderr, "%s is not a valid CppAT trace dump.\n", argv[1]);
+        return 1;
+    }
+    for (uint32_t i = 0; i < decoder.GetNumRecords(); i++)
+    {
+        printf("%s\n", decoder.FormatRecord(i).c_str());
+    }
+    return 0;
+}